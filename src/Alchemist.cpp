@@ -10,9 +10,22 @@
 #include <stdexcept>
 #include <algorithm>
 #include "WeightedRandomizedStack.h"
+#include "SharedIngredientStore.h"
+#include "CombineLog.h"
+#include "Instrumentation.h"
+#include "EffectKernels.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include "AliasTable.h"
 
 using namespace std;
 
+namespace
+{
+	// Parallel foraging's streams, apart from the local streams of the seed.
+	const uint64_t sForageSalt = 0xd6e8feb86659fd93ULL;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //                                 Setup
@@ -21,31 +34,83 @@ using namespace std;
 
 //------------------------------------------------------------------------------
 Alchemist::Alchemist() :
-inventoryValue(0.0), totalIngredientsRemaining(0), worthlessPotionCount(0)
+arena(new Arena()), storeBytes(0), referenceBytes(0), inventoryValue(0.0),
+totalIngredientsRemaining(0), worthlessPotionCount(0), varietiesInStock(0),
+knownValueRemaining(0.0),
+ingredientStore(less<Ingredient>(),
+				IngredientStore::allocator_type(arena.get(), &storeBytes)),
+effectsReference(EffectsReference::allocator_type(arena.get(),
+												  &referenceBytes)),
+sharedStore(nullptr), combineLog(nullptr)
 {
 }
 
+//------------------------------------------------------------------------------
+// Copy constructor - the copy's containers are built in a new arena.
+Alchemist::Alchemist(const Alchemist& rhs) :
+arena(new Arena()), storeBytes(0), referenceBytes(0), inventoryValue(0.0),
+totalIngredientsRemaining(0), worthlessPotionCount(0), varietiesInStock(0),
+knownValueRemaining(0.0),
+ingredientStore(less<Ingredient>(),
+				IngredientStore::allocator_type(arena.get(), &storeBytes)),
+effectsReference(EffectsReference::allocator_type(arena.get(),
+												  &referenceBytes)),
+sharedStore(nullptr), combineLog(nullptr)
+{
+	copyFrom(rhs);
+}
+
+//------------------------------------------------------------------------------
+// Assignment operator - the old state is released with the arena's blocks.
+Alchemist& Alchemist::operator=(const Alchemist& rhs)
+{
+	if (this != &rhs)
+	{
+		// Empty the containers, giving up the reference's capacity too, before
+		// the memory under them is released.
+		this->ingredientStore.clear();
+		EffectsReference(this->effectsReference.get_allocator())
+			.swap(this->effectsReference);
+		this->arena->release();
+		this->storeBytes = this->referenceBytes = 0;
+		copyFrom(rhs);
+	}
+	return *this;
+}
+
 //------------------------------------------------------------------------------
 // 'Discover' a new unique ingredient and make a record of it as empty in stock.
-const Ingredient Alchemist::discoverNewIngredient()
+const Ingredient Alchemist::discoverNewIngredient(RandomStream& random)
 {
 	// Fetch a new ingredient with unique id and properties.
-	const Ingredient ingredient = Ingredient::newIngredient();
+	const Ingredient ingredient = Ingredient::newIngredient(random);
+	discoverIngredient(ingredient);
+	
+	// Return the new ingredient
+	return ingredient;
+}
+
+//------------------------------------------------------------------------------
+bool Alchemist::discoverIngredient(const Ingredient& ingredient)
+{
+	if (this->ingredientTable.rowOf(ingredient) >= 0)
+		return false;
+	POTIONS_COUNT(IngredientsDiscovered);
 	
 	// Add the ingredient to the store with a stock of zero.
 	this->ingredientStore[ingredient] = 0;
+	this->ingredientTable.addIngredient(ingredient);
 	
 	// 'Eat' the ingredient and learn it's first effect
 	learnIngredientEffect(ingredient, ingredient[0]);
-	
-	// Return the new ingredient
-	return ingredient;
+	return true;
 }
 
 //------------------------------------------------------------------------------
 // Forage - adds a specified number of ingredients to the store. The ingredient
 // varieties are determined by the rarities of those that have been 'discovered'
-void Alchemist::forage(const int count)
+void Alchemist::forage(const int count, RandomStream& random,
+					   const bool antithetic)
 {
 	// Generate a WeightedRandomizedStack from the discovered ingredients. This
 	// represents the garden from which ingredients are foraged.
@@ -53,17 +118,132 @@ void Alchemist::forage(const int count)
 	
 	// Fills the garden with potential ingredients and info about rarity.
 	for (auto& p : this->ingredientStore) // p is an Ingredient-int pair
-		garden.push(p.first, 1.0 / p.first.calculateRarity());
+		garden.push(p.first, p.first.getForageWeight());
+	
+	// Draws are multiples of 2^-53 in [0, 1), so u mirrors to 1 - 2^-53 - u,
+	// which stays on the same grid and inside the range.
+	const double mirror = 1.0 - 1.0 / 9007199254740992.0;
 	
 	// Fetch ingredients from the garden the specified number of times.
-	// Increment the stock of each ingredient retrieved.
+	// Increment the stock of each ingredient retrieved, or foraged ingredients
+	// go straight to a shared store.
 	for (int i = 0; i < count; i++)
-		this->ingredientStore[garden.peak()]++;
+	{
+		const double u = random.nextDouble();
+		const Ingredient& ingredient = garden.peakAt(antithetic ? mirror - u : u);
+		if (this->sharedStore)
+			this->sharedStore->add(ingredient, 1);
+		else {
+			POTIONS_COUNT(StoreLookups);
+			this->ingredientStore[ingredient]++;
+		}
+	}
+	if (this->sharedStore)
+		return;
+	
+	// Bring the table's stock column, and the aggregates, up to date.
+	for (auto& p : this->ingredientStore) // p is an Ingredient-int pair
+		setStock(this->ingredientTable.rowOf(p.first), p.second);
 	
 	// Note the increase in stock
 	this->totalIngredientsRemaining += count;
 }
 
+//------------------------------------------------------------------------------
+// Shares are fixed by the pool's size, not by which thread runs them, and the
+// counts are summed in share order, so scheduling can't change the result.
+void Alchemist::forage(const long long count, ThreadPool& pool,
+					   const uint64_t seed)
+{
+	const int rows = this->ingredientTable.size();
+	if (rows == 0 || count <= 0)
+		return;
+	
+	vector<double> weights(rows);
+	for (int row = 0; row < rows; row++)
+		weights[row] = this->ingredientTable.getIngredient(row).getForageWeight();
+	const AliasTable garden(weights);
+	
+	const int shares = pool.size();
+	vector<vector<unsigned int> > counts(shares);
+	for (int i = 0; i < shares; i++)
+		pool.submit([&, i]() {
+			POTIONS_PHASE("forage share");
+			RandomStream random(seed ^ sForageSalt, i);
+			vector<unsigned int>& mine = counts[i];
+			mine.assign(rows, 0);
+			const long long draws = count / shares + (i < count % shares);
+			for (long long d = 0; d < draws; d++)
+				mine[garden.sample(random.nextBits())]++;
+		});
+	pool.wait();
+	
+	for (int row = 0; row < rows; row++)
+	{
+		unsigned int foraged = 0;
+		for (int i = 0; i < shares; i++)
+			foraged += counts[i][row];
+		if (foraged == 0) continue;
+		
+		const Ingredient& ingredient = this->ingredientTable.getIngredient(row);
+		if (this->sharedStore)
+			this->sharedStore->add(ingredient, foraged);
+		else {
+			POTIONS_COUNT(StoreLookups);
+			setStock(row, this->ingredientStore[ingredient] += foraged);
+		}
+	}
+	if (!this->sharedStore)
+		this->totalIngredientsRemaining += count;
+}
+
+//------------------------------------------------------------------------------
+// Check every id before adding any, keeping the map, table and total in step.
+void Alchemist::restock(const vector<uint32_t>& ids)
+{
+	for (const uint32_t id : ids)
+		if (this->ingredientTable.rowOfId(id) < 0)
+			throw invalid_argument("Alchemist::restock() - the alchemist "
+				"doesn't know the ingredient.");
+	
+	for (const uint32_t id : ids)
+	{
+		const Ingredient& ingredient = Ingredient::fromId(id);
+		if (this->sharedStore) {
+			this->sharedStore->add(ingredient, 1);
+			continue;
+		}
+		POTIONS_COUNT(StoreLookups);
+		const int row = this->ingredientTable.rowOfId(id);
+		setStock(row, ++this->ingredientStore[ingredient]);
+		this->totalIngredientsRemaining++;
+	}
+}
+
+//------------------------------------------------------------------------------
+void Alchemist::shareStore(SharedIngredientStore* store)
+{
+	this->sharedStore = store;
+}
+
+//------------------------------------------------------------------------------
+SharedIngredientStore* Alchemist::getSharedStore() const
+{
+	return this->sharedStore;
+}
+
+//------------------------------------------------------------------------------
+void Alchemist::logCombines(CombineLog* log)
+{
+	this->combineLog = log;
+}
+
+//------------------------------------------------------------------------------
+CombineLog* Alchemist::getCombineLog() const
+{
+	return this->combineLog;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //                               Accessors
@@ -85,6 +265,8 @@ int Alchemist::getWorthlessPotionCount() const
 //------------------------------------------------------------------------------
 int Alchemist::getTotalIngredientsRemaining() const
 {
+	if (this->sharedStore)
+		return this->sharedStore->getTotalRemaining();
 	return this->totalIngredientsRemaining;
 }
 
@@ -121,152 +303,670 @@ bool Alchemist::hasIngredient(const Ingredient& ingredient) const
 // Returns the stock count of the specified ingredient
 int Alchemist::countOfIngredient(const Ingredient& ingredient) const
 {
-	// Search for the ingredient in the map.
-	auto iP = this->ingredientStore.find(ingredient); // iP is a pair iterator
-	
-	// Check a value was found.
-	if (iP == this->ingredientStore.end())
-		return 0;
+	return stockOfId(ingredient.getId());
+}
+
+//------------------------------------------------------------------------------
+// Reads the shared store, or the table's stock column.
+unsigned int Alchemist::stockOfId(const unsigned int id) const
+{
+	if (this->sharedStore)
+		return this->sharedStore->countOfId(id);
 	
-	// Return the pair stock value
-	return iP->second;
+	POTIONS_COUNT(TableLookups);
+	const int row = this->ingredientTable.rowOfId(id);
+	return row < 0 ? 0 : this->ingredientTable.getStock(row);
 }
 
 //------------------------------------------------------------------------------
 // Returns the number of ingredient varieties still in stock.
 int Alchemist::calculateVarietiesInStock() const
 {
-	int varietiesInStock = 0;
-	
-	// Increment for each ingredient stock more than 0;
-	for (auto& p : this->ingredientStore) // p is an ingredient-int pair
-		if (p.second > 0) varietiesInStock++;
-		
-	// Return the calculated value
-	return varietiesInStock;
+	if (this->sharedStore)
+		return this->sharedStore->calculateVarietiesInStock();
+	return this->varietiesInStock;
 }
 //------------------------------------------------------------------------------
-// Returns a vector of all StatusEffects in the effectsReference map.
+// Returns a vector of all StatusEffects with a list in effectsReference.
 vector<StatusEffect> Alchemist::allKnownEffects() const
 {
 	vector<StatusEffect> effects;
 	
-	// Add each key to the vector
-	for (auto& p : this->effectsReference) // p is a effect-vector pair
-		effects.push_back(p.first);
+	// Add each listed effect to the vector
+	for (unsigned int id = 1; id < this->effectsReference.size(); id++)
+		if (!this->effectsReference[id].empty())
+			effects.push_back(StatusEffect::fromId(id));
 	
-	// Return all the vector of keys
+	// Return all the vector of effects
 	return effects;
 }
 
 //------------------------------------------------------------------------------
-// Counts the stock of each ingredient listed under an effect
+// Reads the running count, or counts the shared stock of each ingredient
+// listed under an effect.
 unsigned int Alchemist::calculateTotalIngredientsRemainingWithEffect
 	(const StatusEffect& effect) const
 {
+	const PostingList& ids = getIngredientsWithEffect(effect);
+	if (!this->sharedStore)
+		return this->effectStock[effect.getId()].stock;
+	
 	unsigned int count = 0;
-	for (const Ingredient& ingr : this->effectsReference.at(effect))
-		count += this->ingredientStore.at(ingr);
+	for (const uint32_t id : ids)
+		count += stockOfId(id);
 	
 	return count;
 }
 
 //------------------------------------------------------------------------------
-// Returns the vector of ingredients in effectsReference for the effect.
-const vector<Ingredient>& Alchemist::getIngredientsWithEffect
+unsigned int Alchemist::calculateVarietiesInStockWithEffect
+	(const StatusEffect& effect) const
+{
+	const PostingList& ids = getIngredientsWithEffect(effect);
+	if (!this->sharedStore)
+		return this->effectStock[effect.getId()].varieties;
+	
+	unsigned int varieties = 0;
+	for (const uint32_t id : ids)
+		if (stockOfId(id) > 0) varieties++;
+	
+	return varieties;
+}
+
+//------------------------------------------------------------------------------
+// Reads the running sum, or sums the known rarities of each shared row.
+double Alchemist::calculateKnownValueRemaining() const
+{
+	if (!this->sharedStore)
+		return this->knownValueRemaining;
+	
+	double value = 0.0;
+	for (int row = 0; row < this->ingredientTable.size(); row++)
+	{
+		const Ingredient& ingredient = this->ingredientTable.getIngredient(row);
+		const unsigned int stock = stockOfId(ingredient.getId());
+		const uint8_t known = this->ingredientTable.getKnownMask(row);
+		for (int a = 0; a < Ingredient::sMaxEffects; a++)
+			if (known & 1u << a)
+				value += stock * ingredient[a].getRarity();
+	}
+	return value;
+}
+
+//------------------------------------------------------------------------------
+// Every potion's value is the rarity of effects that two of its ingredients
+// share, so a potion valued by an effect uses two of its stock. And a potion's
+// value is at most half its ingredients' known rarities.
+double Alchemist::estimateRemainingValue() const
+{
+	const vector<double>& rarities = StatusEffect::rarityTable();
+	double bound = 0.0;
+	for (size_t id = 1; id < this->effectsReference.size(); id++)
+	{
+		if (this->effectsReference[id].empty())
+			continue;
+		
+		EffectStock counts = {0, 0};
+		if (!this->sharedStore)
+			counts = this->effectStock[id];
+		else for (const uint32_t ingredientId : this->effectsReference[id])
+		{
+			const unsigned int stock = stockOfId(ingredientId);
+			counts.stock += stock;
+			counts.varieties += stock > 0;
+		}
+		
+		if (counts.varieties > 1)
+			bound += rarities[id] * (counts.stock / 2);
+	}
+	
+	return min(bound, calculateKnownValueRemaining() / 2.0);
+}
+
+//------------------------------------------------------------------------------
+// Returns the posting list in effectsReference for the effect.
+const Alchemist::PostingList& Alchemist::getIngredientsWithEffect
 	(const StatusEffect& effect) const
 {
-	return this->effectsReference.at(effect);
+	const unsigned int id = effect.getId();
+	if (id >= this->effectsReference.size()
+		|| this->effectsReference[id].empty())
+		throw out_of_range("Alchemist::getIngredientsWithEffect() - the "
+			"effect is unknown.");
+	return this->effectsReference[id];
 }
 
 //------------------------------------------------------------------------------
-// Returns true if the ingredient is found under the effect in effectsReference.
+// Returns true if the effect's bit is set in the ingredient's table row.
 bool Alchemist::ingredientHasEffect
 	(const Ingredient& ingredient, const StatusEffect& effect) const
 {
-	// Has the effect been registered?
-	auto iRef = this->effectsReference.find(effect); // iRef is a pair iterator
-	if (iRef == this->effectsReference.end())
+	POTIONS_COUNT(TableLookups);
+	const int row = this->ingredientTable.rowOf(ingredient);
+	return row >= 0 && this->ingredientTable.isEffectKnown(row, effect);
+}
+
+//------------------------------------------------------------------------------
+// Searches the ingredient table for the single best partner.
+Ingredient Alchemist::findBestPartner(const Ingredient& ingredient) const
+{
+	const IngredientTable::Partner partner =
+		this->ingredientTable.bestPartner(ingredient);
+	if (partner.row < 0)
+		return Ingredient::nullValue;
+	return this->ingredientTable.getIngredient(partner.row);
+}
+
+//------------------------------------------------------------------------------
+// Searches the ingredient table for the k best partners.
+vector<Ingredient> Alchemist::findBestPartners
+	(const Ingredient& ingredient, const int k) const
+{
+	vector<Ingredient> partners;
+	for (auto& partner : this->ingredientTable.topPartners(ingredient, k))
+		partners.push_back(this->ingredientTable.getIngredient(partner.row));
+	return partners;
+}
+
+//------------------------------------------------------------------------------
+// Only an effect with two stocked varieties can be brewed, and the rarest such
+// is worth the most. Its first two stocked ingredients are suggested.
+bool Alchemist::suggestNextCombine(Ingredient& ingredient1,
+								   Ingredient& ingredient2) const
+{
+	unsigned int bestId = 0;
+	double bestRarity = 0.0;
+	for (unsigned int id = 1; id < this->effectsReference.size(); id++)
+	{
+		if (this->effectsReference[id].empty())
+			continue;
+		const StatusEffect effect = StatusEffect::fromId(id);
+		if (   effect.getRarity() > bestRarity
+			&& calculateVarietiesInStockWithEffect(effect) > 1)
+		{
+			bestId = id;
+			bestRarity = effect.getRarity();
+		}
+	}
+	if (bestId == 0)
 		return false;
 	
-	// Is the ingredient listed under the found effect?
-	const vector<Ingredient>& vec = iRef->second;
-	return find(vec.begin(), vec.end(), ingredient) != vec.end();
+	uint32_t found[2];
+	int count = 0;
+	for (const uint32_t id : this->effectsReference[bestId])
+	{
+		if (stockOfId(id) == 0)
+			continue;
+		found[count++] = id;
+		if (count == 2)
+			break;
+	}
+	ingredient1 = Ingredient::fromId(found[0]);
+	ingredient2 = Ingredient::fromId(found[1]);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+const IngredientTable& Alchemist::getIngredientTable() const
+{
+	return this->ingredientTable;
+}
+
+//------------------------------------------------------------------------------
+// Whatever the arena holds beyond what the store and reference have drawn -
+// unused block space, padding and malloc's overhead - is counted as its own.
+MemoryUsage Alchemist::memoryUsage() const
+{
+	MemoryUsage usage;
+	usage.add("alchemist", sizeof(Alchemist));
+	usage.add("ingredientStore", this->storeBytes);
+	usage.add("effectsReference", this->referenceBytes);
+	usage.add("arena", MemoryUsage::heapBytes(sizeof(Arena))
+			  + this->arena->getBytesHeld() - this->storeBytes
+			  - this->referenceBytes);
+	usage.add("ingredientTable", this->ingredientTable.getBytesHeld());
+	usage.add("aggregates", MemoryUsage::heapBytes(this->effectStock));
+	return usage;
 }
 
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-//                   Effect & Ingredient Stock Queries
+//                          Combining Ingredients
 //
 ////////////////////////////////////////////////////////////////////////////////	
 
 //------------------------------------------------------------------------------
-// Combine ingredients - increase inventory value and record common effects
+// Combine ingredients, which must be in stock.
 Discovery Alchemist::combine
 	(const Ingredient& ingredient1, const Ingredient& ingredient2)
 {
-	// Are both ingredients in stock?
-	if (!hasIngredient(ingredient1) || !hasIngredient(ingredient2))
+	Discovery discovery;
+	if (!tryCombine(ingredient1, ingredient2, &discovery))
 		throw logic_error("Alchemist attempted to combine ingredients that "
 			"weren't in stock.");
-	
+	return discovery;
+}
+
+//------------------------------------------------------------------------------
+Discovery Alchemist::combine(const Ingredient& ingredient1,
+							 const Ingredient& ingredient2,
+							 const Ingredient& ingredient3)
+{
+	Discovery discovery;
+	if (!tryCombine(ingredient1, ingredient2, ingredient3, &discovery))
+		throw logic_error("Alchemist attempted to combine ingredients that "
+			"weren't in stock.");
+	return discovery;
+}
+
+//------------------------------------------------------------------------------
+// Combine ingredients - increase inventory value and record common effects
+bool Alchemist::tryCombine(const Ingredient& ingredient1,
+						   const Ingredient& ingredient2, Discovery* pDiscovery)
+{
 	// Make sure the two ingredients are different.
 	if (ingredient1 == ingredient2)
 		throw invalid_argument("Alchemist::combine() - ingredient1 and "
 			"ingredient2 cannot share the same value");
 	
-	// Remove one of each ingredient from the store
-	this->ingredientStore[ingredient1]--;
-	this->ingredientStore[ingredient2]--;
-	this->totalIngredientsRemaining -= 2;
+	// Remove one of each ingredient from the store, if both are in stock.
+	const Ingredient* ingredients[2] = {&ingredient1, &ingredient2};
+	if (!takeStock(ingredients, 2))
+		return false;
 	
 	// Findings from this combination will be returned with this object.
 	// If nothing is learned on gained, this will be returned empty.
 	Discovery discovery;
+	discovery.potionValue = brew(ingredient1, ingredient2, discovery);
 	
+	POTIONS_RECORD(DiscoveriesPerCombine, discovery.findingsCount());
+	if (this->combineLog)
+		this->combineLog->append(ingredients, 2, discovery);
+	
+	if (pDiscovery)
+		*pDiscovery = discovery;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Learns the effects two ingredients share, noting each new one in the
+// findings. The potion's value is the rarest's rarity.
+template<class Findings>
+double Alchemist::brew(const Ingredient& ingredient1,
+					   const Ingredient& ingredient2, Findings& findings)
+{
 	// Find the rarest matching status effects in the ingredients.
 	const StatusEffect* pRarestEffect = nullptr;
 	
-	// Loop over all possible effect combinations and check for matches.
-	for (const StatusEffect& eff1 : ingredient1)
-		for (const StatusEffect& eff2 : ingredient2)
-			if (eff1 == eff2)
-			{
-				// Note the match if none were previously found.
-				if (!pRarestEffect)
-					pRarestEffect = &eff1;
-				// Else, note the match if the effect's rarer than the last.
-				else if (pRarestEffect->getRarity() < eff1.getRarity())
-					pRarestEffect = &eff1;
-				
-				// Check if the effects have already been discovered, and learn 
-				// them if not. Note anything learned in the returned Discovery.
-				if (!ingredientHasEffect(ingredient1, eff1)) {
-					learnIngredientEffect(ingredient1, eff1);
-					discovery.addFinding(ingredient1, eff1);
-				}
-				if (!ingredientHasEffect(ingredient2, eff2)) {
-					learnIngredientEffect(ingredient2, eff2);
-					discovery.addFinding(ingredient2, eff2);
+	// Check which of the first ingredient's effects the second shares.
+	const StatusEffect* effects = ingredient1.begin();
+	const unsigned int shared = EffectKernels::sharedMask
+		<Ingredient::sMaxEffects>(effects, ingredient2.begin());
+	for (int a = 0; a < Ingredient::sMaxEffects; a++)
+	{
+		if (!(shared & 1u << a)) continue;
+		const StatusEffect& effect = effects[a];
+		
+		// Note the match if none were previously found, or it's rarer.
+		if (!pRarestEffect || pRarestEffect->getRarity() < effect.getRarity())
+			pRarestEffect = &effect;
+		
+		// Check if the effect has already been discovered in each ingredient,
+		// and learn it if not. Note anything learned in the returned Discovery.
+		if (!ingredientHasEffect(ingredient1, effect)) {
+			learnIngredientEffect(ingredient1, effect);
+			findings.addFinding(ingredient1, effect);
+		}
+		if (!ingredientHasEffect(ingredient2, effect)) {
+			learnIngredientEffect(ingredient2, effect);
+			findings.addFinding(ingredient2, effect);
+		}
+	}
+	
+	// If a match was found, set the potion's value as the effect's rarity.
+	double potionValue = 0.0;
+	if (pRarestEffect) {
+		potionValue = pRarestEffect->getRarity();
+		
+		// Increase the inventory's value by that of the potion
+		this->inventoryValue += potionValue;
+	}
+	// Otherwise, note the waste of ingredients
+	else {
+		this->worthlessPotionCount++;
+	}
+	
+	POTIONS_COUNT(Combines);
+	POTIONS_RECORD(PotionValue, potionValue);
+	return potionValue;
+}
+
+//------------------------------------------------------------------------------
+// Combine three ingredients - effects found in two or more of them match. The
+// potion's value is the sum of the two rarest matches.
+bool Alchemist::tryCombine(const Ingredient& ingredient1,
+						   const Ingredient& ingredient2,
+						   const Ingredient& ingredient3, Discovery* pDiscovery)
+{
+	// Make sure the three ingredients are different.
+	if (   ingredient1 == ingredient2 || ingredient1 == ingredient3
+		|| ingredient2 == ingredient3)
+		throw invalid_argument("Alchemist::combine() - ingredient1, "
+			"ingredient2 and ingredient3 must all have different values");
+	
+	// Remove one of each ingredient from the store, if all are in stock.
+	const Ingredient* ingredients[3] = {&ingredient1, &ingredient2, &ingredient3};
+	if (!takeStock(ingredients, 3))
+		return false;
+	
+	// Findings from this combination will be returned with this object.
+	// If nothing is learned on gained, this will be returned empty.
+	Discovery discovery;
+	discovery.potionValue = brew(ingredient1, ingredient2, ingredient3,
+								 discovery);
+	
+	POTIONS_RECORD(DiscoveriesPerCombine, discovery.findingsCount());
+	if (this->combineLog)
+		this->combineLog->append(ingredients, 3, discovery);
+	
+	if (pDiscovery)
+		*pDiscovery = discovery;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Learns the effects that two or more of three ingredients share, noting each
+// new one in the findings. The potion's value is the two rarest's rarities.
+template<class Findings>
+double Alchemist::brew(const Ingredient& ingredient1,
+					   const Ingredient& ingredient2,
+					   const Ingredient& ingredient3, Findings& findings)
+{
+	const Ingredient* ingredients[3] = {&ingredient1, &ingredient2, &ingredient3};
+	
+	// The two rarest matching effects, rarest first.
+	const StatusEffect* pRarestEffects[2] = {nullptr, nullptr};
+	
+	// shared[i][j] has bit a set if effect a of ingredient i is one of
+	// ingredient j's. Only the first two ingredients' effects are needed - a
+	// match in the third is counted under an earlier ingredient.
+	const StatusEffect* effects[3] = {ingredient1.begin(), ingredient2.begin(),
+									  ingredient3.begin()};
+	unsigned int shared[2][3] = {{0, 0, 0}, {0, 0, 0}};
+	for (int i = 0; i < 2; i++)
+		for (int j = 0; j < 3; j++)
+			if (i != j)
+				shared[i][j] = EffectKernels::sharedMask
+					<Ingredient::sMaxEffects>(effects[i], effects[j]);
+	
+	// Check each effect of each ingredient against the later ingredients.
+	// Effects are unique within an ingredient, so a match is counted once,
+	// under the first ingredient that has it.
+	for (int i = 0; i < 2; i++)
+		for (int a = 0; a < Ingredient::sMaxEffects; a++)
+		{
+			// Skip effects already matched with an earlier ingredient.
+			const unsigned int bit = 1u << a;
+			if (i == 1 && (shared[1][0] & bit)) continue;
+			
+			// Find which later ingredients share the effect.
+			const StatusEffect& effect = effects[i][a];
+			bool matched = false;
+			for (int j = i + 1; j < 3; j++)
+				if (shared[i][j] & bit)
+				{
+					matched = true;
+					if (!ingredientHasEffect(*ingredients[j], effect)) {
+						learnIngredientEffect(*ingredients[j], effect);
+						findings.addFinding(*ingredients[j], effect);
+					}
 				}
+			if (!matched) continue;
+			
+			if (!ingredientHasEffect(*ingredients[i], effect)) {
+				learnIngredientEffect(*ingredients[i], effect);
+				findings.addFinding(*ingredients[i], effect);
 			}
 			
-	// If a match was found, set the potion's value as the effect's rarity.
-	if (pRarestEffect) {
-		discovery.potionValue = pRarestEffect->getRarity();
+			// Keep the match if it's one of the two rarest so far.
+			if (!pRarestEffects[0]
+				|| pRarestEffects[0]->getRarity() < effect.getRarity()) {
+				pRarestEffects[1] = pRarestEffects[0];
+				pRarestEffects[0] = &effect;
+			}
+			else if (!pRarestEffects[1]
+				|| pRarestEffects[1]->getRarity() < effect.getRarity())
+				pRarestEffects[1] = &effect;
+		}
+	
+	// If matches were found, the potion's value is the sum of their rarities.
+	double potionValue = 0.0;
+	if (pRarestEffects[0]) {
+		potionValue = pRarestEffects[0]->getRarity();
+		if (pRarestEffects[1])
+			potionValue += pRarestEffects[1]->getRarity();
 		
 		// Increase the inventory's value by that of the potion
-		this->inventoryValue += discovery.potionValue;
+		this->inventoryValue += potionValue;
 	}
 	// Otherwise, note the waste of ingredients
 	else {
 		this->worthlessPotionCount++;
 	}
 	
-	return discovery;
+	POTIONS_COUNT(Combines);
+	POTIONS_RECORD(PotionValue, potionValue);
+	return potionValue;
 }
 
+//------------------------------------------------------------------------------
+// Replaying skips the search for matching effects - the findings say what was
+// learned, and learning an effect twice does no harm.
+void Alchemist::replayCombine(const Ingredient* const* ingredients,
+							  const int count, const Discovery& discovery)
+{
+	if (!takeStock(ingredients, count))
+		throw logic_error("Alchemist attempted to replay a combine of "
+			"ingredients that weren't in stock.");
+	
+	for (int i = 0; i < discovery.findingsCount(); i++)
+		learnIngredientEffect(discovery.getIngredient(i),
+							  discovery.getEffect(i));
+	
+	if (discovery.potionValue > 0.0)
+		this->inventoryValue += discovery.potionValue;
+	else
+		this->worthlessPotionCount++;
+	
+	POTIONS_COUNT(Combines);
+	if (this->combineLog)
+		this->combineLog->append(ingredients, count, discovery);
+}
+
+//------------------------------------------------------------------------------
+// Check every count before taking any, then bring the map, table and total up
+// to date once per ingredient. The values are added in order, so the
+// inventory's value comes out as it would combine by combine.
+void Alchemist::replayCombines(const vector<unsigned int>& usedById,
+							   const vector<double>& values,
+							   const vector<Discovery>& discoveries)
+{
+	if (this->sharedStore)
+		throw logic_error("Alchemist attempted to replay combines together "
+			"from a shared store.");
+	for (unsigned int id = 0; id < usedById.size(); id++)
+		if (usedById[id] > stockOfId(id))
+			throw logic_error("Alchemist attempted to replay combines of "
+				"ingredients that weren't in stock.");
+	
+	for (unsigned int id = 0; id < usedById.size(); id++)
+	{
+		if (usedById[id] == 0) continue;
+		const int row = this->ingredientTable.rowOfId(id);
+		const unsigned int stock =
+			this->ingredientTable.getStock(row) - usedById[id];
+		this->ingredientStore[this->ingredientTable.getIngredient(row)] = stock;
+		setStock(row, stock);
+		this->totalIngredientsRemaining -= usedById[id];
+	}
+	
+	for (const Discovery& discovery : discoveries)
+		for (int i = 0; i < discovery.findingsCount(); i++)
+			learnIngredientEffect(discovery.getIngredient(i),
+								  discovery.getEffect(i));
+	
+	for (const double value : values)
+		if (value > 0.0)
+			this->inventoryValue += value;
+		else
+			this->worthlessPotionCount++;
+	POTIONS_COUNT_N(Combines, values.size());
+}
+
+//------------------------------------------------------------------------------
+// Count each row's uses over the whole batch, check them against stock, and
+// take them in one step per row. Brewing needs only knowledge, not stock, so
+// the combines then brew as they would have one by one.
+void Alchemist::combineBatch(const BatchCombine* combines, const size_t count,
+							 BatchResults& results)
+{
+	if (this->sharedStore)
+		throw logic_error("Alchemist attempted to combine a batch from a "
+			"shared store.");
+	
+	results.clear();
+	vector<uint32_t>& uses = results.uses;
+	uses.assign(this->ingredientTable.size(), 0);
+	for (size_t c = 0; c < count; c++)
+	{
+		const uint32_t* ids = combines[c].ids;
+		const int size = ids[2] ? 3 : 2;
+		if (ids[0] == ids[1] || ids[0] == ids[2] || ids[1] == ids[2])
+			throw invalid_argument("Alchemist::combineBatch() - a combine's "
+				"ingredients must all differ.");
+		for (int i = 0; i < size; i++) {
+			const int row = this->ingredientTable.rowOfId(ids[i]);
+			if (row < 0)
+				throw invalid_argument("Alchemist::combineBatch() - the "
+					"alchemist doesn't know an ingredient.");
+			uses[row]++;
+		}
+	}
+	for (int row = 0; row < this->ingredientTable.size(); row++)
+		if (uses[row] > this->ingredientTable.getStock(row))
+			throw logic_error("Alchemist attempted to combine a batch of "
+				"ingredients that weren't in stock.");
+	
+	for (int row = 0; row < this->ingredientTable.size(); row++)
+	{
+		if (uses[row] == 0) continue;
+		POTIONS_COUNT(StoreLookups);
+		const unsigned int stock = this->ingredientTable.getStock(row) - uses[row];
+		this->ingredientStore[this->ingredientTable.getIngredient(row)] = stock;
+		setStock(row, stock);
+		this->totalIngredientsRemaining -= uses[row];
+	}
+	
+	for (size_t c = 0; c < count; c++)
+	{
+		const uint32_t* ids = combines[c].ids;
+		const Ingredient& ingredient1 = Ingredient::fromId(ids[0]);
+		const Ingredient& ingredient2 = Ingredient::fromId(ids[1]);
+		const size_t firstFinding = results.findings.size();
+		const double value = ids[2]
+			? brew(ingredient1, ingredient2, Ingredient::fromId(ids[2]), results)
+			: brew(ingredient1, ingredient2, results);
+		results.endCombine(value);
+		POTIONS_RECORD(DiscoveriesPerCombine,
+					   results.findings.size() - firstFinding);
+		
+		// Only a log needs the combine as a Discovery.
+		if (this->combineLog)
+		{
+			Discovery discovery;
+			discovery.potionValue = value;
+			for (size_t f = firstFinding; f < results.findings.size(); f++)
+				discovery.addFinding
+					(Ingredient::fromId(results.findings[f].ingredientId),
+					 StatusEffect::fromId(results.findings[f].effectId));
+			const Ingredient* ingredients[3] = {&ingredient1, &ingredient2,
+				ids[2] ? &Ingredient::fromId(ids[2]) : nullptr};
+			this->combineLog->append(ingredients, ids[2] ? 3 : 2, discovery);
+		}
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//                            Sharing Knowledge
+//
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+// Each list is merged in place from the back: the new ids are counted, the list
+// is grown by that many, then both lists are walked from their largest ids,
+// filling the list from its end.
+int Alchemist::learnFrom(const Alchemist& other)
+{
+	if (this == &other)
+		return 0;
+	
+	// Record any ingredients this alchemist hasn't met, without stock.
+	for (int row = 0; row < other.ingredientTable.size(); row++) {
+		const Ingredient& ingredient = other.ingredientTable.getIngredient(row);
+		if (this->ingredientTable.rowOf(ingredient) < 0) {
+			this->ingredientStore[ingredient] = 0;
+			this->ingredientTable.addIngredient(ingredient);
+		}
+	}
+	
+	if (other.effectsReference.size() > this->effectsReference.size()) {
+		this->effectsReference.resize(other.effectsReference.size(),
+			PostingList(PostingList::allocator_type(this->arena.get(),
+													&this->referenceBytes)));
+		this->effectStock.resize(other.effectsReference.size(),
+								 EffectStock());
+	}
+	
+	int learned = 0;
+	for (unsigned int id = 1; id < other.effectsReference.size(); id++)
+	{
+		const PostingList& theirs = other.effectsReference[id];
+		PostingList& ours = this->effectsReference[id];
+		
+		// Count the ids only they list.
+		size_t newIds = 0;
+		for (size_t i = 0, j = 0; j < theirs.size(); )
+			if (i == ours.size() || theirs[j] < ours[i]) { newIds++; j++; }
+			else if (ours[i] < theirs[j]) i++;
+			else { i++; j++; }
+		if (newIds == 0) continue;
+		
+		const StatusEffect effect = StatusEffect::fromId(id);
+		size_t i = ours.size(), j = theirs.size(), out = i + newIds;
+		ours.resize(out);
+		while (j > 0)
+		{
+			if (i > 0 && ours[i - 1] > theirs[j - 1])
+				ours[--out] = ours[--i];
+			else {
+				if (i > 0 && ours[i - 1] == theirs[j - 1])
+					--i;
+				else {
+					const int row = this->ingredientTable.rowOfId(theirs[j - 1]);
+					this->ingredientTable.markEffectKnown(row, effect);
+					countKnownEffect(row, effect);
+					learned++;
+				}
+				ours[--out] = theirs[--j];
+			}
+		}
+	}
+	
+	return learned;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 //
@@ -274,11 +974,97 @@ Discovery Alchemist::combine
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+//------------------------------------------------------------------------------
+// Copies another alchemist's state. The containers must be empty, and keep
+// their own allocators, so the copied elements are placed in this arena.
+void Alchemist::copyFrom(const Alchemist& rhs)
+{
+	this->inventoryValue = rhs.inventoryValue;
+	this->totalIngredientsRemaining = rhs.totalIngredientsRemaining;
+	this->worthlessPotionCount = rhs.worthlessPotionCount;
+	this->varietiesInStock = rhs.varietiesInStock;
+	this->knownValueRemaining = rhs.knownValueRemaining;
+	this->effectStock = rhs.effectStock;
+	this->ingredientTable = rhs.ingredientTable;
+	this->sharedStore = rhs.sharedStore;
+	
+	this->ingredientStore.insert(rhs.ingredientStore.begin(),
+								 rhs.ingredientStore.end());
+	
+	const PostingList::allocator_type allocator(this->arena.get(),
+												&this->referenceBytes);
+	for (const PostingList& ids : rhs.effectsReference)
+		this->effectsReference.push_back
+			(PostingList(ids.begin(), ids.end(), allocator));
+}
+
+//------------------------------------------------------------------------------
+// Claims from the shared store if there is one. Otherwise checks every count
+// before taking any, keeping the map, table and total in step.
+bool Alchemist::takeStock(const Ingredient* const* ingredients, const int count)
+{
+	if (this->sharedStore)
+		return this->sharedStore->tryClaim(ingredients, count);
+	
+	for (int i = 0; i < count; i++)
+		if (!hasIngredient(*ingredients[i]))
+			return false;
+	
+	POTIONS_COUNT_N(StoreLookups, count);
+	POTIONS_COUNT_N(TableLookups, count);
+	for (int i = 0; i < count; i++) {
+		const unsigned int stock = --this->ingredientStore[*ingredients[i]];
+		setStock(this->ingredientTable.rowOf(*ingredients[i]), stock);
+	}
+	this->totalIngredientsRemaining -= count;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// The change is counted under each of the row's known effects - at most
+// sMaxEffects of them, so this takes constant time.
+void Alchemist::setStock(const int row, const unsigned int stock)
+{
+	const unsigned int old = this->ingredientTable.getStock(row);
+	this->ingredientTable.setStock(row, stock);
+	if (stock == old)
+		return;
+	
+	const int varietyChange = (stock > 0) - (old > 0);
+	const double change = double(stock) - double(old);
+	this->varietiesInStock += varietyChange;
+	
+	const Ingredient& ingredient = this->ingredientTable.getIngredient(row);
+	const uint8_t known = this->ingredientTable.getKnownMask(row);
+	for (int a = 0; a < Ingredient::sMaxEffects; a++)
+	{
+		if (!(known & 1u << a)) continue;
+		EffectStock& counts = this->effectStock[ingredient[a].getId()];
+		counts.stock += stock - old; // Wraps back round if stock fell
+		counts.varieties += varietyChange;
+		this->knownValueRemaining += change * ingredient[a].getRarity();
+	}
+}
+
+//------------------------------------------------------------------------------
+void Alchemist::countKnownEffect(const int row, const StatusEffect& effect)
+{
+	const unsigned int stock = this->ingredientTable.getStock(row);
+	EffectStock& counts = this->effectStock[effect.getId()];
+	counts.stock += stock;
+	counts.varieties += stock > 0;
+	this->knownValueRemaining += stock * effect.getRarity();
+}
+
 //------------------------------------------------------------------------------
 // Notes a new status effect for an ingredient. 
 void Alchemist::learnIngredientEffect
 	(const Ingredient& ingredient, const StatusEffect& effect)
 {
+	POTIONS_COUNT(EffectsLearned);
+	POTIONS_COUNT(StoreLookups);
+	POTIONS_COUNT(TableLookups);
+	
 	// Check the ingredient is know to the alchemist
 	// iStore is an ingredient-int pair iterator
 	auto iStore = this->ingredientStore.find(ingredient);
@@ -286,19 +1072,26 @@ void Alchemist::learnIngredientEffect
 		throw logic_error("Alchemist attempted to learn the effect of an "
 			"ingredient that it's encountered before.");
 	
-	// Look for the status effect in the effectsRefence.
-	auto iRef = this->effectsReference.find(effect); // effect-vec pair iterator
-	
-	// Add the effect to the reference if it hasn't been before, along with the
-	// ingredient exhibiting the effect.
-	if (iRef == this->effectsReference.end()) {
-		this->effectsReference[effect] = vector<Ingredient>({ingredient});
+	// Grow the reference, and the aggregates, to hold the effect.
+	const unsigned int id = effect.getId();
+	if (id >= this->effectsReference.size()) {
+		this->effectsReference.resize(id + 1,
+			PostingList(PostingList::allocator_type(this->arena.get(),
+													&this->referenceBytes)));
+		this->effectStock.resize(id + 1, EffectStock());
 	}
 	
-	// Otherwise add the ingredient under the effect if it hasn't been already.
-	else {
-		vector<Ingredient>& vec = iRef->second;
-		if (find(vec.begin(), vec.end(), ingredient) == vec.end())
-			vec.push_back(ingredient);
-		}
+	// Mirror the knowledge in the ingredient table, counting the ingredient's
+	// stock under the effect if it's new.
+	const int row = this->ingredientTable.rowOf(ingredient);
+	const uint8_t known = this->ingredientTable.getKnownMask(row);
+	this->ingredientTable.markEffectKnown(row, effect);
+	if (this->ingredientTable.getKnownMask(row) != known)
+		countKnownEffect(row, effect);
+	
+	// Insert the ingredient's id in order, if it isn't listed already.
+	PostingList& ids = this->effectsReference[id];
+	auto iId = lower_bound(ids.begin(), ids.end(), ingredient.getId());
+	if (iId == ids.end() || *iId != ingredient.getId())
+		ids.insert(iId, ingredient.getId());
 }
\ No newline at end of file
@@ -30,16 +30,52 @@
 #pragma once
 #include <vector>
 #include <map>
+#include <memory>
+#include "Arena.h"
 #include "Ingredient.h"
 #include "Discovery.h"
+#include "IngredientTable.h"
+#include "MemoryUsage.h"
+#include "CombineBatch.h"
 
+class SharedIngredientStore;
+class CombineLog;
+class ThreadPool;
 
 class Alchemist
 {
+public:
+	// The ids of the ingredients known to have an effect, in ascending order.
+	// Posting lists are drawn from the alchemist's arena.
+	typedef std::vector<uint32_t, ArenaAllocator<uint32_t> > PostingList;
+
+private:
+	typedef std::map<Ingredient, unsigned int, std::less<Ingredient>,
+		ArenaAllocator<std::pair<const Ingredient, unsigned int> > >
+		IngredientStore;
+	typedef std::vector<PostingList, ArenaAllocator<PostingList> >
+		EffectsReference;
+	
+	// The stock, and the varieties in stock, of the ingredients known to have
+	// an effect.
+	struct EffectStock
+	{
+		unsigned int stock;
+		unsigned int varieties;
+	};
+
 //------------------------------------------------------------------------------
 //                             Private members
 //------------------------------------------------------------------------------
 
+	// Backs the store and reference containers. Every allocation they make
+	// lasts until the alchemist is destroyed, so they are released together.
+	std::unique_ptr<Arena> arena;
+	
+	// The bytes the store and reference have drawn from the arena.
+	std::size_t storeBytes;
+	std::size_t referenceBytes;
+
 	// The combined value of all the brewed potions.
 	double inventoryValue;
 	
@@ -48,12 +84,28 @@ class Alchemist
 	
 	// Keep a count of combinations that gained nothing.
 	int worthlessPotionCount;
+	
+	// Running aggregates of the alchemist's own stock, brought up to date by
+	// each change to stock or knowledge so that queries needn't walk it.
+	int varietiesInStock;
+	double knownValueRemaining;
+	std::vector<EffectStock> effectStock; // Indexed by effect id
 
 	// Holds the quantity of each ingredient.
-	std::map<Ingredient, unsigned int> ingredientStore;
+	IngredientStore ingredientStore;
 
-	// Sorts ingredients by their discovered effects
-	std::map<StatusEffect, std::vector<Ingredient> > effectsReference;
+	// Lists ingredients by their discovered effects, indexed by effect id.
+	EffectsReference effectsReference;
+	
+	// Mirrors the store and reference as contiguous columns for fast searches.
+	IngredientTable ingredientTable;
+	
+	// When set, stock is claimed from this store - shared with alchemists on
+	// other threads - in place of the alchemist's own.
+	SharedIngredientStore* sharedStore;
+	
+	// When set, every combine is appended to this log.
+	CombineLog* combineLog;
 	
 //------------------------------------------------------------------------------
 //                                 Setup
@@ -63,14 +115,48 @@ public:
 	
 	// Initializes an alchemist with no discoveries or stock.
 	Alchemist();
+	
+	// Copies are given their own arena.
+	Alchemist(const Alchemist& rhs);
+	Alchemist& operator=(const Alchemist& rhs);
 
 	// Returns a new ingredient with random status effects and set's stock 
 	// to zero. The ingredient's first status effect is also discovered
-	const Ingredient discoverNewIngredient();
+	const Ingredient discoverNewIngredient
+		(RandomStream& random = RandomStream::local());
+	
+	// As above, but for an existing ingredient - from a procedural world, say.
+	// Returns false, changing nothing, if the ingredient is already known.
+	bool discoverIngredient(const Ingredient& ingredient);
 
 	// Refills the alchemist's stores by the specified amount with ingredients
-	// according to their rarities.
-	void forage(const int count);
+	// according to their rarities. An antithetic forage mirrors each draw
+	// from the stream, so paired with a plain forage from an identical stream
+	// their deviations from the expected stock tend to cancel.
+	void forage(const int count, RandomStream& random = RandomStream::local(),
+				const bool antithetic = false);
+	
+	// As above, but split across the pool's threads. Each draws its share from
+	// its own stream, salted from the seed by share, into private counts that
+	// are added to stock at the end - so the stock depends only on the seed
+	// and the pool's size. Draws take constant time from an alias table.
+	void forage(const long long count, ThreadPool& pool, const uint64_t seed);
+	
+	// Adds one of each ingredient to stock, by id - as foraged elsewhere.
+	// Throws invalid_argument, adding none, if any isn't known.
+	void restock(const std::vector<uint32_t>& ids);
+	
+	// Brews from the shared store, or from the alchemist's own stock again if
+	// null. The alchemist's own stock is set aside, not merged, and its table's
+	// stock column - used by the partner searches - isn't kept up to date while
+	// shared. Knowledge is never shared.
+	void shareStore(SharedIngredientStore* store);
+	SharedIngredientStore* getSharedStore() const;
+	
+	// Appends every later combine to the log, or stops logging if null. The
+	// log isn't copied with the alchemist.
+	void logCombines(CombineLog* log);
+	CombineLog* getCombineLog() const;
 	
 //------------------------------------------------------------------------------
 //                            Member accessors
@@ -93,8 +179,11 @@ public:
 
 	// Returns the stock count for the specified ingredient.
 	int countOfIngredient(const Ingredient& ingredient) const;
+	unsigned int stockOfId(const unsigned int id) const;
 	
 	// Returns the number of remaining of ingredient varieties still in stock.
+	// This and the effect queries below read running counts in constant time,
+	// unless the store is shared.
 	int calculateVarietiesInStock() const;
 	
 	// Returns a vector containing all status effects known by the alchemist.
@@ -104,14 +193,54 @@ public:
 	// specified effect.
 	unsigned int calculateTotalIngredientsRemainingWithEffect
 		(const StatusEffect& effect) const;
+	
+	// Returns the number of varieties in stock known to have the specified
+	// effect. Throws out_of_range if the effect is unknown.
+	unsigned int calculateVarietiesInStockWithEffect
+		(const StatusEffect& effect) const;
+	
+	// Returns the known value of the stock: each ingredient remaining counts
+	// the sum of its known effects' rarities.
+	double calculateKnownValueRemaining() const;
+	
+	// Returns an upper bound on the value of the potions the stock can still
+	// brew from known matching effects - no more than half an effect's stock
+	// can be brewed for it, or half the stock's known value in all. Matches
+	// not yet discovered aren't counted. Reads the running counts, so takes
+	// time linear in the number of effects.
+	double estimateRemainingValue() const;
 
-	// Returns all ingredients known to have the specified status effect
-	const std::vector<Ingredient>& getIngredientsWithEffect
+	// Returns the ids of all ingredients known to have the specified status
+	// effect, in ascending order. Throws out_of_range if the effect is unknown.
+	const PostingList& getIngredientsWithEffect
 		(const StatusEffect& effect) const;
 	
 	// Returns true if an ingredient is known to express the status effect.
 	bool ingredientHasEffect
 		(const Ingredient& ingredient, const StatusEffect& effect) const;
+	
+	// Returns the stocked ingredient sharing the most valuable known effect
+	// with the specified ingredient, or Ingredient::nullValue if none does.
+	Ingredient findBestPartner(const Ingredient& ingredient) const;
+	
+	// As above, but returns up to k partners, most valuable first.
+	std::vector<Ingredient> findBestPartners
+		(const Ingredient& ingredient, const int k) const;
+	
+	// Finds the most valuable combine known to be possible: two stocked
+	// ingredients sharing the rarest known effect that any two stocked
+	// ingredients share. Returns false, leaving the ingredients unchanged, if
+	// no two do. Reads the running counts, so takes time linear in the number
+	// of effects and the chosen effect's ingredients.
+	bool suggestNextCombine(Ingredient& ingredient1,
+							Ingredient& ingredient2) const;
+	
+	// Read access to the structure-of-arrays mirror of the ingredients.
+	const IngredientTable& getIngredientTable() const;
+	
+	// The memory the alchemist holds: the store and reference, the rest of
+	// the arena they're drawn from, the table, and the running aggregates.
+	MemoryUsage memoryUsage() const;
 
 //------------------------------------------------------------------------------
 //                            Combining Ingredients
@@ -123,6 +252,50 @@ public:
 		(const Ingredient& i1, const Ingredient& i2);
 	Discovery combine
 		(const Ingredient& i1, const Ingredient& i2, const Ingredient& i3);
+	
+	// As above, but returns false rather than throwing if an ingredient is out
+	// of stock - as one may be at any moment when the store is shared. The
+	// discovery is written to the pointer if one is given.
+	bool tryCombine(const Ingredient& i1, const Ingredient& i2,
+					Discovery* discovery = nullptr);
+	bool tryCombine(const Ingredient& i1, const Ingredient& i2,
+					const Ingredient& i3, Discovery* discovery = nullptr);
+	
+	// Applies a combine's recorded outcome without working it out: takes the
+	// ingredients from stock, learns the findings and adds the potion's value.
+	// Throws logic_error if an ingredient is out of stock.
+	void replayCombine(const Ingredient* const* ingredients, const int count,
+					   const Discovery& discovery);
+	
+	// As above, but for a run of combines at once: usedById counts the
+	// ingredients they take by id, values lists their potions' values in
+	// order, and discoveries holds what they learned. Each ingredient's stock is
+	// updated once, so this is much faster than replaying them one by one. The
+	// combines aren't logged. Throws logic_error, changing nothing, if more of
+	// an ingredient is used than is in stock or the store is shared.
+	void replayCombines(const std::vector<unsigned int>& usedById,
+						const std::vector<double>& values,
+						const std::vector<Discovery>& discoveries);
+	
+	// Brews a batch of combines in order, writing their values and findings
+	// to the results, which are cleared first. Stock is checked for the whole
+	// batch at once, and taken once per ingredient. Throws invalid_argument if
+	// a combine repeats an ingredient or names one the alchemist doesn't
+	// know, or logic_error if the batch needs more of an ingredient than is
+	// in stock or the store is shared - brewing none.
+	void combineBatch(const BatchCombine* combines, const size_t count,
+					  BatchResults& results);
+
+//------------------------------------------------------------------------------
+//                             Sharing Knowledge
+//------------------------------------------------------------------------------
+
+	// Learns everything the other alchemist knows, and returns the number of
+	// ingredient effects that were new. Ingredients not known before are added
+	// with no stock. Each effect's posting lists are merged in one pass, so the
+	// time taken is linear in the size of the two alchemists' knowledge. The
+	// other alchemist mustn't be changed meanwhile.
+	int learnFrom(const Alchemist& other);
 
 //------------------------------------------------------------------------------
 //                              Private methods
@@ -130,6 +303,29 @@ public:
 
 private:
 	
+	// Copies the rhs alchemist's state into this one's arena.
+	void copyFrom(const Alchemist& rhs);
+	
+	// Takes one of each ingredient from stock, or none if any has run out.
+	bool takeStock(const Ingredient* const* ingredients, const int count);
+	
+	// Sets the stock of the table's row, and brings the running aggregates up
+	// to date. The store map and total are left to the caller.
+	void setStock(const int row, const unsigned int stock);
+	
+	// Adds the row's stock to the aggregates of an effect newly known for it.
+	void countKnownEffect(const int row, const StatusEffect& effect);
+	
+	// Work out a combine of ingredients already taken from stock: learn the
+	// effects they share, adding each new one to the findings - a Discovery
+	// or BatchResults - and add the potion's value, which is returned.
+	template<class Findings>
+	double brew(const Ingredient& ingredient1, const Ingredient& ingredient2,
+				Findings& findings);
+	template<class Findings>
+	double brew(const Ingredient& ingredient1, const Ingredient& ingredient2,
+				const Ingredient& ingredient3, Findings& findings);
+	
 	// Note that an ingredient expresses a particular status effect.
 	void learnIngredientEffect
 		(const Ingredient& ingredient, const StatusEffect& effect);
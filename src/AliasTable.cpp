@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        AliasTable.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (fixed width integers)
+ ******************************************************************************/
+
+#include "AliasTable.h"
+#include <stdexcept>
+#include "MemoryUsage.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// Scale so the average column is 1, then top up each small column from a
+// large one. Whatever is left once either list runs out is full, give or take
+// rounding, so keeps its own index.
+AliasTable::AliasTable(const vector<double>& weights) :
+thresholds(weights.size(), 1ULL << 32), aliases(weights.size())
+{
+	const size_t n = weights.size();
+	double total = 0.0;
+	for (const double weight : weights) {
+		if (weight < 0.0)
+			throw invalid_argument("AliasTable() - weights can't be negative.");
+		total += weight;
+	}
+	if (!(total > 0.0))
+		throw invalid_argument("AliasTable() - the weights must have a "
+			"positive sum.");
+
+	vector<double> scaled(n);
+	vector<uint32_t> small, large;
+	for (size_t i = 0; i < n; i++) {
+		scaled[i] = weights[i] * n / total;
+		this->aliases[i] = i;
+		(scaled[i] < 1.0 ? small : large).push_back(i);
+	}
+
+	while (!small.empty() && !large.empty())
+	{
+		const uint32_t s = small.back(), l = large.back();
+		small.pop_back();
+		this->thresholds[s] = uint64_t(scaled[s] * 4294967296.0);
+		this->aliases[s] = l;
+		scaled[l] -= 1.0 - scaled[s];
+		if (scaled[l] < 1.0) {
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+size_t AliasTable::size() const
+{
+	return this->thresholds.size();
+}
+
+//------------------------------------------------------------------------------
+size_t AliasTable::getBytesHeld() const
+{
+	return MemoryUsage::heapBytes(this->thresholds)
+		+ MemoryUsage::heapBytes(this->aliases);
+}
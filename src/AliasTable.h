@@ -0,0 +1,48 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        AliasTable.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (fixed width integers)
+ *
+ * Draws indices in proportion to fixed weights in constant time, by Walker's
+ * alias method: each of n columns holds its own index up to a threshold, and
+ * an alias above it, so a draw is one column and one comparison. The table is
+ * built by Vose's method, in linear time.
+ *
+ * A draw consumes one 64-bit word - from a RandomStream, or a counter-based
+ * generator - so callers control where the randomness comes from.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+
+class AliasTable
+{
+	// Thresholds out of 2^32.
+	std::vector<uint64_t> thresholds;
+	std::vector<uint32_t> aliases;
+
+public:
+	// Builds the table for the weights, which mustn't be negative and must
+	// have a positive sum. Throws invalid_argument if they don't.
+	explicit AliasTable(const std::vector<double>& weights);
+
+	// The number of weights.
+	size_t size() const;
+
+	// The bytes the table holds on the heap.
+	size_t getBytesHeld() const;
+
+	// Draws an index from 64 uniformly random bits. The high half picks the
+	// column, the low half the side.
+	uint32_t sample(const uint64_t bits) const
+	{
+		const uint32_t column = ((bits >> 32) * this->thresholds.size()) >> 32;
+		return (bits & 0xffffffffULL) < this->thresholds[column]
+			? column : this->aliases[column];
+	}
+};
@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        Arena.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (allocator_traits)
+ ******************************************************************************/
+
+#include "Arena.h"
+#include <cstdint>
+#include <algorithm>
+#include "MemoryUsage.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+Arena::Arena(const size_t blockSize) :
+cursor(nullptr), remaining(0), blockSize(blockSize), bytesReserved(0),
+bytesUsed(0), bytesHeld(0)
+{
+}
+
+//------------------------------------------------------------------------------
+Arena::~Arena()
+{
+	release();
+}
+
+//------------------------------------------------------------------------------
+// Bump the cursor past the aligned allocation, starting a new block if the
+// current one doesn't have room.
+void* Arena::allocate(const size_t bytes, const size_t alignment)
+{
+	size_t padding = (alignment - reinterpret_cast<uintptr_t>(this->cursor)
+					  % alignment) % alignment;
+
+	if (!this->cursor || padding + bytes > this->remaining)
+	{
+		// Oversized requests get a block of their own.
+		const size_t size = max(this->blockSize, bytes + alignment);
+		this->blocks.push_back(new char[size]);
+		this->cursor = this->blocks.back();
+		this->remaining = size;
+		this->bytesReserved += size;
+		this->bytesHeld += MemoryUsage::heapBytes(size);
+
+		padding = (alignment - reinterpret_cast<uintptr_t>(this->cursor)
+				   % alignment) % alignment;
+	}
+
+	void* memory = this->cursor + padding;
+	this->cursor += padding + bytes;
+	this->remaining -= padding + bytes;
+	this->bytesUsed += bytes;
+
+	return memory;
+}
+
+//------------------------------------------------------------------------------
+// Free every block at once.
+void Arena::release()
+{
+	for (char* block : this->blocks)
+		delete[] block;
+
+	this->blocks.clear();
+	this->cursor = nullptr;
+	this->remaining = 0;
+	this->bytesReserved = 0;
+	this->bytesUsed = 0;
+	this->bytesHeld = 0;
+}
+
+//------------------------------------------------------------------------------
+size_t Arena::getBytesReserved() const
+{
+	return this->bytesReserved;
+}
+
+size_t Arena::getBytesUsed() const
+{
+	return this->bytesUsed;
+}
+
+//------------------------------------------------------------------------------
+size_t Arena::getBytesHeld() const
+{
+	return this->bytesHeld + MemoryUsage::heapBytes(this->blocks);
+}
@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        Arena.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (allocator_traits)
+ *
+ * A monotonic memory arena and an STL allocator drawing from it. The arena
+ * hands out memory by bumping a cursor through large blocks, and never frees
+ * individual allocations - everything is released at once when the arena is
+ * released or destroyed. This suits a simulation's containers, which only
+ * grow until the simulation ends.
+ *
+ * An Arena is not thread-safe; each simulation should own its own.
+ ******************************************************************************/
+
+#pragma once
+#include <cstddef>
+#include <vector>
+
+
+class Arena
+{
+	// Every block obtained from the heap, freed together.
+	std::vector<char*> blocks;
+
+	// The next free byte in the current block, and the space left after it.
+	char* cursor;
+	std::size_t remaining;
+
+	// The size of each new block, unless an allocation needs more.
+	std::size_t blockSize;
+
+	// Running totals of bytes obtained from the heap and handed out, and of
+	// the heap's blocks with malloc's overhead.
+	std::size_t bytesReserved;
+	std::size_t bytesUsed;
+	std::size_t bytesHeld;
+
+	// Arenas own their blocks, so can't be copied.
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+
+public:
+	static const std::size_t sDefaultBlockSize = 64 * 1024;
+
+	// Initializes an arena with no blocks.
+	explicit Arena(const std::size_t blockSize = sDefaultBlockSize);
+	~Arena();
+
+	// Returns uninitialized memory of the given size and alignment.
+	void* allocate(const std::size_t bytes, const std::size_t alignment);
+
+	// Frees every block. Anything allocated from the arena becomes invalid.
+	void release();
+
+	// The bytes obtained from the heap, and those handed out from them.
+	std::size_t getBytesReserved() const;
+	std::size_t getBytesUsed() const;
+
+	// The bytes the arena holds on the heap - its blocks, with malloc's
+	// overhead, and its list of them.
+	std::size_t getBytesHeld() const;
+};
+
+
+//------------------------------------------------------------------------------
+// Allocator adapter so standard containers can draw from an Arena.
+// Deallocation does nothing - memory is reclaimed when the arena is released.
+// Given a tally, every allocation adds its bytes to it, so a container can
+// account for what it has drawn - including blocks it has since given up.
+template<class T> class ArenaAllocator
+{
+	Arena* arena;
+	std::size_t* tally;
+
+	template<class U> friend class ArenaAllocator;
+
+public:
+	typedef T value_type;
+
+	explicit ArenaAllocator(Arena* arena, std::size_t* tally = nullptr) :
+		arena(arena), tally(tally) {}
+
+	template<class U>
+	ArenaAllocator(const ArenaAllocator<U>& rhs) :
+		arena(rhs.arena), tally(rhs.tally) {}
+
+	T* allocate(const std::size_t n)
+	{
+		if (tally)
+			*tally += n * sizeof(T);
+		return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, const std::size_t) {}
+
+	Arena* getArena() const { return arena; }
+
+	template<class U>
+	bool operator==(const ArenaAllocator<U>& rhs) const
+	{
+		return arena == rhs.arena;
+	}
+
+	template<class U>
+	bool operator!=(const ArenaAllocator<U>& rhs) const
+	{
+		return arena != rhs.arena;
+	}
+};
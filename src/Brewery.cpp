@@ -0,0 +1,146 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        Brewery.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<thread>, <functional>, <chrono>)
+ ******************************************************************************/
+
+#include "Brewery.h"
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <exception>
+#include <string>
+#include "Trace.h"
+
+using namespace std;
+
+namespace
+{
+	// The alchemists' streams, apart from the local streams of the seed.
+	const uint64_t sBrewSalt = 0xa0761d6478bd642fULL;
+}
+
+//------------------------------------------------------------------------------
+// Reserve room for the alchemists first, so the copies never move.
+Brewery::Brewery(const Alchemist& source, const int alchemistCount) :
+store(source), commonKnowledge(source)
+{
+	const int count = alchemistCount > 0 ? alchemistCount : 1;
+	this->alchemists.reserve(count);
+	for (int i = 0; i < count; i++) {
+		this->alchemists.push_back(source);
+		this->alchemists.back().shareStore(&this->store);
+	}
+}
+
+//------------------------------------------------------------------------------
+// One thread per alchemist, timed from the first start to the last join.
+double Brewery::brew(const Strategy& strategy, const uint64_t seed)
+{
+	mutex failureMutex;
+	exception_ptr failure;
+
+	const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	vector<thread> threads;
+	for (size_t i = 0; i < this->alchemists.size(); i++)
+		threads.push_back(thread([&, i]() {
+			Trace::nameThread(("alchemist " + to_string(i)).c_str());
+			POTIONS_PHASE("brew");
+			RandomStream random(seed ^ sBrewSalt, i);
+			try {
+				strategy(this->alchemists[i], random);
+			}
+			catch (...) {
+				lock_guard<mutex> lock(failureMutex);
+				if (!failure)
+					failure = current_exception();
+			}
+		}));
+	for (thread& t : threads)
+		t.join();
+
+	const chrono::duration<double> elapsed =
+		chrono::steady_clock::now() - start;
+
+	if (failure)
+		rethrow_exception(failure);
+	return elapsed.count();
+}
+
+//------------------------------------------------------------------------------
+int Brewery::shareKnowledge(Alchemist& alchemist)
+{
+	lock_guard<mutex> lock(this->knowledgeMutex);
+	this->commonKnowledge.learnFrom(alchemist);
+	return alchemist.learnFrom(this->commonKnowledge);
+}
+
+//------------------------------------------------------------------------------
+// Gather everything into the common knowledge, then hand it back out, so each
+// alchemist's knowledge is merged twice rather than with every other's.
+void Brewery::shareAllKnowledge()
+{
+	lock_guard<mutex> lock(this->knowledgeMutex);
+	for (const Alchemist& alchemist : this->alchemists)
+		this->commonKnowledge.learnFrom(alchemist);
+	for (Alchemist& alchemist : this->alchemists)
+		alchemist.learnFrom(this->commonKnowledge);
+}
+
+//------------------------------------------------------------------------------
+const Alchemist& Brewery::getCommonKnowledge() const
+{
+	return this->commonKnowledge;
+}
+
+//------------------------------------------------------------------------------
+vector<Alchemist>& Brewery::getAlchemists()
+{
+	return this->alchemists;
+}
+
+//------------------------------------------------------------------------------
+const vector<Alchemist>& Brewery::getAlchemists() const
+{
+	return this->alchemists;
+}
+
+//------------------------------------------------------------------------------
+const SharedIngredientStore& Brewery::getStore() const
+{
+	return this->store;
+}
+
+//------------------------------------------------------------------------------
+double Brewery::getInventoryValue() const
+{
+	double value = 0.0;
+	for (const Alchemist& alchemist : this->alchemists)
+		value += alchemist.getInventoryValue();
+	return value;
+}
+
+//------------------------------------------------------------------------------
+int Brewery::getWorthlessPotionCount() const
+{
+	int count = 0;
+	for (const Alchemist& alchemist : this->alchemists)
+		count += alchemist.getWorthlessPotionCount();
+	return count;
+}
+
+//------------------------------------------------------------------------------
+// Stock is shared, so is counted once.
+int Brewery::calculateVarietiesInStock() const
+{
+	return this->store.calculateVarietiesInStock();
+}
+
+//------------------------------------------------------------------------------
+int Brewery::getTotalIngredientsRemaining() const
+{
+	return this->store.getTotalRemaining();
+}
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        Brewery.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<thread>, <functional>, <chrono>)
+ *
+ * A brewery runs several alchemists at once, each on its own thread, brewing
+ * from one shared ingredient store. Every alchemist starts as a copy of the
+ * same source, so they share its knowledge at the start, but each learns only
+ * from its own potions afterwards.
+ *
+ * Each alchemist is given its own random stream, from the brewery's seed,
+ * salted, by worker index.
+ *
+ * Alchemists can pool what they've learned through the brewery's common
+ * knowledge: a strategy calls shareKnowledge() to add its alchemist's
+ * findings to the pool and learn everyone else's so far.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <cstdint>
+#include "Alchemist.h"
+#include "SharedIngredientStore.h"
+#include "Random.h"
+
+
+class Brewery
+{
+public:
+	// The instructions each alchemist follows, on its own thread.
+	typedef std::function<void(Alchemist&, RandomStream&)> Strategy;
+
+private:
+	// The store every alchemist brews from.
+	SharedIngredientStore store;
+
+	// Everything the alchemists have shared, guarded by the mutex. Its stock
+	// is the source's, and is never used.
+	Alchemist commonKnowledge;
+	std::mutex knowledgeMutex;
+	
+	// One alchemist per worker thread.
+	std::vector<Alchemist> alchemists;
+
+	// Alchemists point at the store, so breweries can't be copied.
+	Brewery(const Brewery&);
+	Brewery& operator=(const Brewery&);
+
+public:
+	// Copies the source's stock into a shared store, and hires the specified
+	// number of alchemists knowing what the source knows.
+	Brewery(const Alchemist& source, const int alchemistCount);
+
+	// Runs the strategy for every alchemist at once, and returns the seconds
+	// taken for them all to finish. The first exception thrown by a strategy
+	// is rethrown once all have finished.
+	double brew(const Strategy& strategy, const uint64_t seed);
+
+	// Adds the alchemist's knowledge to the common knowledge, then teaches it
+	// all the common knowledge. Returns the number of ingredient effects the
+	// alchemist learned. Safe to call from strategies, each for its own
+	// alchemist.
+	int shareKnowledge(Alchemist& alchemist);
+
+	// Teaches every alchemist what all of them know. Not to be called while
+	// brewing.
+	void shareAllKnowledge();
+
+	const Alchemist& getCommonKnowledge() const;
+
+	std::vector<Alchemist>& getAlchemists();
+	const std::vector<Alchemist>& getAlchemists() const;
+	const SharedIngredientStore& getStore() const;
+
+	// Totals across the alchemists.
+	double getInventoryValue() const;
+	int getWorthlessPotionCount() const;
+	int calculateVarietiesInStock() const;
+	int getTotalIngredientsRemaining() const;
+};
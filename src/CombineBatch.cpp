@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        CombineBatch.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (fixed width integers)
+ ******************************************************************************/
+
+#include "CombineBatch.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+void BatchResults::clear()
+{
+	this->values.clear();
+	this->findings.clear();
+	this->findingEnds.clear();
+}
+
+//------------------------------------------------------------------------------
+int BatchResults::size() const
+{
+	return this->values.size();
+}
+
+//------------------------------------------------------------------------------
+double BatchResults::getValue(const int combine) const
+{
+	return this->values[combine];
+}
+
+//------------------------------------------------------------------------------
+// A combine's findings start where the previous combine's end.
+const BatchResults::Finding* BatchResults::findingsBegin
+	(const int combine) const
+{
+	return this->findings.data() + (combine ? this->findingEnds[combine - 1] : 0);
+}
+
+const BatchResults::Finding* BatchResults::findingsEnd
+	(const int combine) const
+{
+	return this->findings.data() + this->findingEnds[combine];
+}
+
+//------------------------------------------------------------------------------
+const vector<BatchResults::Finding>& BatchResults::allFindings() const
+{
+	return this->findings;
+}
+
+//------------------------------------------------------------------------------
+void BatchResults::addFinding(const Ingredient& ingredient,
+							  const StatusEffect& effect)
+{
+	const Finding finding = {ingredient.getId(), effect.getId()};
+	this->findings.push_back(finding);
+}
+
+//------------------------------------------------------------------------------
+void BatchResults::endCombine(const double value)
+{
+	this->values.push_back(value);
+	this->findingEnds.push_back(this->findings.size());
+}
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        CombineBatch.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (fixed width integers)
+ *
+ * The input and output of Alchemist::combineBatch(). A batch is a run of
+ * combines, each naming its ingredients by id, and its results are their
+ * potions' values and findings - as ids, in flat arrays, rather than a
+ * Discovery per potion.
+ *
+ * BatchResults is meant to be kept and reused from batch to batch: clearing
+ * it keeps its capacity, so once it has grown to a batch's size, brewing more
+ * batches allocates nothing.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Ingredient.h"
+
+// Two or three ingredients to combine, by id. The third id is 0 for a pair.
+struct BatchCombine
+{
+	uint32_t ids[3];
+};
+
+
+class BatchResults
+{
+public:
+	// An effect learned for an ingredient, by id.
+	struct Finding
+	{
+		uint32_t ingredientId;
+		uint32_t effectId;
+	};
+
+private:
+	// Each combine's potion value, 0 if it was worthless.
+	std::vector<double> values;
+
+	// Every combine's findings in order, and where each combine's end.
+	std::vector<Finding> findings;
+	std::vector<uint32_t> findingEnds;
+
+	// Working space for combineBatch(), counting the uses of each row.
+	std::vector<uint32_t> uses;
+
+	friend class Alchemist;
+
+public:
+	// Forgets every result, keeping the capacity for the next batch.
+	void clear();
+
+	// The number of combines with results.
+	int size() const;
+
+	// The combine's potion value, 0 if it was worthless.
+	double getValue(const int combine) const;
+
+	// The combine's findings, as a range.
+	const Finding* findingsBegin(const int combine) const;
+	const Finding* findingsEnd(const int combine) const;
+
+	// Every combine's findings, in order.
+	const std::vector<Finding>& allFindings() const;
+
+	// Used while brewing: notes a finding of the combine under way, and ends
+	// it with its potion's value.
+	void addFinding(const Ingredient& ingredient, const StatusEffect& effect);
+	void endCombine(const double value);
+};
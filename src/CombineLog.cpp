@@ -0,0 +1,381 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        CombineLog.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (thread_local, <atomic>, fixed width integers)
+ ******************************************************************************/
+
+#include "CombineLog.h"
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include "Alchemist.h"
+
+using namespace std;
+
+namespace
+{
+	const char sMagic[4] = {'P', 'C', 'L', 'G'};
+	const uint32_t sVersion = 2;
+	const uint32_t sEffects = Ingredient::sMaxEffects;
+
+	// Buffers are written out once they reach this size.
+	const size_t sChunkSize = 64 * 1024;
+
+	// The most bytes a record can take.
+	const size_t sMaxRecordSize = 1 + 3 * sizeof(uint32_t)
+		+ Discovery::sMaxFindings + sizeof(double);
+	
+	template<class T> void put(uint8_t*& p, const T& value)
+	{
+		memcpy(p, &value, sizeof(T));
+		p += sizeof(T);
+	}
+
+	template<class T> T take(const uint8_t*& p, const uint8_t* end)
+	{
+		if (end - p < static_cast<ptrdiff_t>(sizeof(T)))
+			throw invalid_argument("CombineLog::read() - a record is cut "
+				"short.");
+		T value;
+		memcpy(&value, p, sizeof(T));
+		p += sizeof(T);
+		return value;
+	}
+	
+	// The record's outcome, as tryCombine would have returned it.
+	Discovery toDiscovery(const CombineLog::Record& record)
+	{
+		Discovery discovery;
+		for (int f = 0; f < record.findingCount; f++)
+			discovery.addFinding
+				(Ingredient::fromId(record.findingIngredients[f]),
+				 StatusEffect::fromId(record.findingEffects[f]));
+		discovery.potionValue = record.value;
+		return discovery;
+	}
+	
+	bool sameOutcome(const Discovery& lhs, const Discovery& rhs)
+	{
+		if (   lhs.potionValue != rhs.potionValue
+			|| lhs.findingsCount() != rhs.findingsCount())
+			return false;
+		for (int f = 0; f < lhs.findingsCount(); f++)
+			if (   !(lhs.getIngredient(f) == rhs.getIngredient(f))
+				|| !(lhs.getEffect(f) == rhs.getEffect(f)))
+				return false;
+		return true;
+	}
+	
+	// Walks a log's chunks, passing each decoded record to the visitor.
+	template<class Visitor> void decode(istream& in, Visitor visit)
+	{
+		char magic[sizeof(sMagic)];
+		uint32_t version = 0, effects = 0;
+		in.read(magic, sizeof(magic));
+		in.read(reinterpret_cast<char*>(&version), sizeof(version));
+		in.read(reinterpret_cast<char*>(&effects), sizeof(effects));
+		if (!in || !equal(magic, magic + sizeof(magic), sMagic)
+			|| version != sVersion)
+			throw invalid_argument("CombineLog::read() - not a combine log.");
+		if (effects != sEffects)
+			throw invalid_argument("CombineLog::read() - the log was made "
+				"with " + to_string(effects) + " effects per ingredient.");
+		
+		vector<uint8_t> bytes;
+		uint32_t header[2];
+		CombineLog::Record record;
+		while (in.read(reinterpret_cast<char*>(header), sizeof(header)))
+		{
+			bytes.resize(header[1]);
+			if (!in.read(reinterpret_cast<char*>(bytes.data()), bytes.size()))
+				throw invalid_argument("CombineLog::read() - a chunk is cut "
+					"short.");
+			
+			const uint8_t* p = bytes.data();
+			const uint8_t* const end = p + bytes.size();
+			record.stream = header[0];
+			while (p < end)
+			{
+				const uint8_t counts = take<uint8_t>(p, end);
+				record.ingredientCount = counts & 3;
+				record.findingCount = (counts >> 2) & 31;
+				if (   record.ingredientCount < 2
+					|| record.findingCount > Discovery::sMaxFindings)
+					throw invalid_argument("CombineLog::read() - a record is "
+						"malformed.");
+				
+				for (int i = 0; i < record.ingredientCount; i++)
+					record.ingredients[i] = take<uint32_t>(p, end);
+				for (int f = 0; f < record.findingCount; f++) {
+					const uint8_t finding = take<uint8_t>(p, end);
+					if ((finding >> 4) >= record.ingredientCount)
+						throw invalid_argument("CombineLog::read() - a record "
+							"is malformed.");
+					const uint32_t id = record.ingredients[finding >> 4];
+					record.findingIngredients[f] = id;
+					record.findingEffects[f] =
+						Ingredient::fromId(id)[finding & 15].getId();
+				}
+				record.value = take<double>(p, end);
+				visit(record);
+			}
+		}
+	}
+	
+	// Applies records to an alchemist. Outcomes are gathered and applied
+	// together when they can be, else applied or verified one by one.
+	class Replayer
+	{
+		Alchemist& alchemist;
+		const bool verify;
+		const bool together;
+		int applied;
+		
+		vector<unsigned int> usedById;
+		vector<double> values;
+		vector<Discovery> discoveries;
+		
+	public:
+		Replayer(Alchemist& alchemist, const bool verify) :
+		alchemist(alchemist), verify(verify),
+		together(!verify && !alchemist.getCombineLog()
+				 && !alchemist.getSharedStore()),
+		applied(0) {}
+		
+		void apply(const CombineLog::Record& record)
+		{
+			if (this->together)
+			{
+				for (int i = 0; i < record.ingredientCount; i++) {
+					const uint32_t id = record.ingredients[i];
+					if (id >= this->usedById.size())
+						this->usedById.resize(id + 1, 0);
+					this->usedById[id]++;
+				}
+				this->values.push_back(record.value);
+				if (record.findingCount > 0)
+					this->discoveries.push_back(toDiscovery(record));
+				this->applied++;
+				return;
+			}
+			
+			const Ingredient* ingredients[3];
+			for (int i = 0; i < record.ingredientCount; i++)
+				ingredients[i] = &Ingredient::fromId(record.ingredients[i]);
+			const Discovery recorded = toDiscovery(record);
+			
+			if (this->verify)
+			{
+				Discovery discovery;
+				const bool combined = record.ingredientCount == 2
+					? this->alchemist.tryCombine(*ingredients[0],
+						*ingredients[1], &discovery)
+					: this->alchemist.tryCombine(*ingredients[0],
+						*ingredients[1], *ingredients[2], &discovery);
+				if (!combined || !sameOutcome(discovery, recorded))
+					throw logic_error("CombineLog::replay() - combine "
+						+ to_string(this->applied) + " doesn't match its "
+						"record.");
+			}
+			else this->alchemist.replayCombine(ingredients,
+				record.ingredientCount, recorded);
+			this->applied++;
+		}
+		
+		// Applies any gathered outcomes, and returns the number of records.
+		int finish()
+		{
+			if (this->together)
+				this->alchemist.replayCombines(this->usedById, this->values,
+											   this->discoveries);
+			return this->applied;
+		}
+	};
+}
+
+//------------------------------------------------------------------------------
+// The log the buffer belongs to is null once the log has been destroyed. The
+// log clears it under its lock while the buffer's thread reads it without, so
+// it's atomic - released by the log, acquired by the thread.
+struct CombineLog::Buffer
+{
+	atomic<CombineLog*> log;
+	uint32_t stream;
+	vector<uint8_t> bytes;
+};
+
+//------------------------------------------------------------------------------
+// Hands each buffer back to its log when the thread exits.
+struct CombineLog::ThreadBuffers
+{
+	vector<Buffer*> buffers;
+
+	~ThreadBuffers()
+	{
+		for (Buffer* buffer : buffers) {
+			CombineLog* const log = buffer->log.load(memory_order_acquire);
+			if (log)
+				log->retireBuffer(*buffer);
+			delete buffer;
+		}
+	}
+};
+
+//------------------------------------------------------------------------------
+CombineLog::CombineLog(ostream& out) :
+out(out), nextStream(0)
+{
+	this->out.write(sMagic, sizeof(sMagic));
+	this->out.write(reinterpret_cast<const char*>(&sVersion), sizeof(sVersion));
+	this->out.write(reinterpret_cast<const char*>(&sEffects), sizeof(sEffects));
+}
+
+//------------------------------------------------------------------------------
+// Flush, then cut the buffers loose - their threads free them on exit.
+CombineLog::~CombineLog()
+{
+	lock_guard<mutex> lock(this->outMutex);
+	for (Buffer* buffer : this->buffers) {
+		writeChunk(*buffer);
+		buffer->log.store(nullptr, memory_order_release);
+	}
+	this->out.flush();
+}
+
+//------------------------------------------------------------------------------
+// Findings are stored by where they are in the combine - which ingredient,
+// and which of its effect slots.
+void CombineLog::append(const Ingredient* const* ingredients, const int count,
+						const Discovery& discovery)
+{
+	Buffer& buffer = localBuffer();
+	vector<uint8_t>& bytes = buffer.bytes;
+	
+	// Write in place, then trim the space the record didn't use.
+	const size_t start = bytes.size();
+	bytes.resize(start + sMaxRecordSize);
+	uint8_t* p = bytes.data() + start;
+	
+	const int findings = discovery.findingsCount();
+	*p++ = uint8_t(count | findings << 2);
+	for (int i = 0; i < count; i++)
+		put<uint32_t>(p, ingredients[i]->getId());
+	
+	for (int f = 0; f < findings; f++)
+	{
+		const Ingredient& ingredient = discovery.getIngredient(f);
+		int index = 0;
+		while (index + 1 < count && !(*ingredients[index] == ingredient))
+			index++;
+		const int slot = find(ingredient.begin(), ingredient.end(),
+							  discovery.getEffect(f)) - ingredient.begin();
+		*p++ = uint8_t(index << 4 | slot);
+	}
+	put<double>(p, discovery.potionValue);
+	bytes.resize(p - bytes.data());
+	
+	if (bytes.size() >= sChunkSize) {
+		lock_guard<mutex> lock(this->outMutex);
+		writeChunk(buffer);
+	}
+}
+
+//------------------------------------------------------------------------------
+void CombineLog::flush()
+{
+	lock_guard<mutex> lock(this->outMutex);
+	for (Buffer* buffer : this->buffers)
+		writeChunk(*buffer);
+	this->out.flush();
+}
+
+//------------------------------------------------------------------------------
+vector<CombineLog::Record> CombineLog::read(istream& in)
+{
+	vector<Record> records;
+	decode(in, [&records](const Record& record)
+		   { records.push_back(record); });
+	return records;
+}
+
+//------------------------------------------------------------------------------
+int CombineLog::replay(Alchemist& alchemist, const vector<Record>& records,
+					   const bool verify)
+{
+	Replayer replayer(alchemist, verify);
+	for (const Record& record : records)
+		replayer.apply(record);
+	return replayer.finish();
+}
+
+//------------------------------------------------------------------------------
+int CombineLog::replay(Alchemist& alchemist, istream& in, const bool verify)
+{
+	Replayer replayer(alchemist, verify);
+	decode(in, [&replayer](const Record& record) { replayer.apply(record); });
+	return replayer.finish();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//                              Private Methods
+//
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+// A thread rarely appends to more than one log, so a linear search is enough.
+// Buffers of destroyed logs are dropped as they're passed.
+CombineLog::Buffer& CombineLog::localBuffer()
+{
+	thread_local ThreadBuffers tBuffers;
+	vector<Buffer*>& buffers = tBuffers.buffers;
+	for (size_t i = 0; i < buffers.size(); )
+	{
+		const CombineLog* const log =
+			buffers[i]->log.load(memory_order_acquire);
+		if (log == this)
+			return *buffers[i];
+		if (!log) {
+			delete buffers[i];
+			buffers.erase(buffers.begin() + i);
+		}
+		else i++;
+	}
+
+	Buffer* buffer = new Buffer();
+	buffer->log.store(this, memory_order_relaxed);
+	buffer->bytes.reserve(sChunkSize + sMaxRecordSize);
+	{
+		lock_guard<mutex> lock(this->outMutex);
+		buffer->stream = this->nextStream++;
+		this->buffers.push_back(buffer);
+	}
+	buffers.push_back(buffer);
+	return *buffer;
+}
+
+//------------------------------------------------------------------------------
+void CombineLog::writeChunk(Buffer& buffer)
+{
+	if (buffer.bytes.empty())
+		return;
+
+	const uint32_t header[2] = {buffer.stream, uint32_t(buffer.bytes.size())};
+	this->out.write(reinterpret_cast<const char*>(header), sizeof(header));
+	this->out.write(reinterpret_cast<const char*>(buffer.bytes.data()),
+					buffer.bytes.size());
+	buffer.bytes.clear();
+}
+
+//------------------------------------------------------------------------------
+void CombineLog::retireBuffer(Buffer& buffer)
+{
+	lock_guard<mutex> lock(this->outMutex);
+	writeChunk(buffer);
+	this->buffers.erase(find(this->buffers.begin(), this->buffers.end(),
+							 &buffer));
+}
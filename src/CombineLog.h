@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        CombineLog.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (thread_local, fixed width integers)
+ *
+ * A compact binary log of combines: the ingredients, what was learned, and
+ * the potion's value. An alchemist given a log appends every combine to it.
+ *
+ * Each thread appends to its own buffer, without locking, and the buffer is
+ * written to the log's stream as a chunk when it fills, when the log is
+ * flushed, or when the thread exits. Each thread's records form a stream of
+ * their own, numbered in the order threads first append. Flushing and
+ * destroying the log must wait until no thread is appending.
+ *
+ * Format, in native byte order: the file starts "PCLG", a uint32 version and
+ * the uint32 number of effects per ingredient the log was built with, as
+ * effect slots mean nothing with another. Each chunk is a uint32 stream number
+ * and uint32 byte count, then records. A record is a byte holding the
+ * ingredient count (low 2 bits) and finding count (next 5 bits), the uint32
+ * ingredient ids, one byte per finding holding the ingredient's index (high 4
+ * bits) and effect slot (low 4 bits), then the potion value as a double.
+ *
+ * Replaying a log re-applies the recorded outcomes to a copy of the world the
+ * log was made in, without searching for combines or matching effects, to
+ * reproduce or analyse a run cheaply.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <mutex>
+#include <cstdint>
+#include "Ingredient.h"
+#include "Discovery.h"
+
+class Alchemist;
+
+class CombineLog
+{
+public:
+	// A combine, as read back from a log.
+	struct Record
+	{
+		uint32_t stream;
+		int ingredientCount;
+		uint32_t ingredients[3];
+		int findingCount;
+		uint32_t findingIngredients[Discovery::sMaxFindings];
+		uint32_t findingEffects[Discovery::sMaxFindings];
+		double value;
+	};
+
+private:
+	// A thread's buffered records for one log, and the set of them a thread
+	// owns.
+	struct Buffer;
+	struct ThreadBuffers;
+
+	std::ostream& out;
+
+	// Guards the stream, and the list of buffers.
+	std::mutex outMutex;
+	std::vector<Buffer*> buffers;
+
+	// The stream number the next thread to append is given.
+	uint32_t nextStream;
+
+	// Returns the calling thread's buffer, creating one if needed.
+	Buffer& localBuffer();
+
+	// Writes the buffer as a chunk and empties it. The caller holds the mutex.
+	void writeChunk(Buffer& buffer);
+
+	// Writes out an exiting thread's buffer, and forgets it.
+	void retireBuffer(Buffer& buffer);
+
+	// Logs are tied to their stream and buffers, so can't be copied.
+	CombineLog(const CombineLog&);
+	CombineLog& operator=(const CombineLog&);
+
+public:
+	// Starts a log on the stream, writing the file header.
+	explicit CombineLog(std::ostream& out);
+
+	// Flushes every buffer.
+	~CombineLog();
+
+	// Records a combine of count ingredients, on the calling thread's buffer.
+	void append(const Ingredient* const* ingredients, const int count,
+				const Discovery& discovery);
+
+	// Writes every thread's buffered records to the stream.
+	void flush();
+
+	// Reads every record in a log, in the order the chunks were written.
+	// Throws invalid_argument if the data isn't a combine log, or was logged
+	// with a different number of effects per ingredient.
+	static std::vector<Record> read(std::istream& in);
+	
+	// Applies the records' outcomes to the alchemist, in order, and returns the
+	// number applied. The alchemist must start as the logged one did. Unless
+	// the alchemist is logging or shares a store, the outcomes are applied
+	// together, touching each ingredient's stock once. When verifying, each
+	// combine is worked out again and checked against its record; a
+	// logic_error is thrown at the first that differs.
+	static int replay(Alchemist& alchemist, const std::vector<Record>& records,
+					  const bool verify = false);
+	
+	// As above, but decoding the records straight from a log, without keeping
+	// them. Throws invalid_argument if the data isn't a combine log.
+	static int replay(Alchemist& alchemist, std::istream& in,
+					  const bool verify = false);
+};
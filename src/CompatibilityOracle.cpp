@@ -0,0 +1,209 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        CompatibilityOracle.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (fixed width integers)
+ ******************************************************************************/
+
+#include "CompatibilityOracle.h"
+#include <algorithm>
+#include "Alchemist.h"
+
+using namespace std;
+
+namespace
+{
+	// Rows per build task.
+	const int sRowsPerTask = 256;
+
+	uint64_t pairKey(const unsigned int id1, const unsigned int id2)
+	{
+		return id1 < id2 ? (uint64_t(id1) << 32) | id2
+						 : (uint64_t(id2) << 32) | id1;
+	}
+}
+
+//------------------------------------------------------------------------------
+// List each effect's rows, find every row's partners in parallel, then pack
+// the rows' edges into the CSR arrays and hash table.
+CompatibilityOracle::CompatibilityOracle(const vector<Ingredient>& ingredients,
+										 ThreadPool& pool) :
+ingredients(ingredients), slotShift(64)
+{
+	const int rows = this->ingredients.size();
+
+	vector<vector<uint32_t> > rowsByEffect;
+	for (int row = 0; row < rows; row++)
+	{
+		const Ingredient& ingredient = this->ingredients[row];
+		const unsigned int id = ingredient.getId();
+		if (id >= this->rowsById.size())
+			this->rowsById.resize(id + 1, -1);
+		this->rowsById[id] = row;
+
+		for (const StatusEffect& effect : ingredient) {
+			if (effect.getId() >= rowsByEffect.size())
+				rowsByEffect.resize(effect.getId() + 1);
+			rowsByEffect[effect.getId()].push_back(row);
+		}
+	}
+
+	// Each task has its own scratch values, so tasks never share writes.
+	vector<vector<Edge> > rowEdges(rows);
+	for (int first = 0; first < rows; first += sRowsPerTask)
+		pool.submit([&, first]() {
+			vector<float> values(rows, 0.0f);
+			vector<uint32_t> effects(rows, 0);
+			const int last = min(rows, first + sRowsPerTask);
+			for (int row = first; row < last; row++)
+				findPartners(row, rowsByEffect, values, effects, rowEdges[row]);
+		});
+	pool.wait();
+
+	this->offsets.assign(1, 0);
+	this->bestValues.assign(rows, 0.0f);
+	for (int row = 0; row < rows; row++)
+	{
+		this->edges.insert(this->edges.end(), rowEdges[row].begin(),
+						   rowEdges[row].end());
+		this->offsets.push_back(this->edges.size());
+		for (const Edge& edge : rowEdges[row])
+			this->bestValues[row] = max(this->bestValues[row], edge.value);
+		vector<Edge>().swap(rowEdges[row]);
+	}
+
+	// Size the table to at least twice the pairs.
+	size_t size = 2;
+	this->slotShift = 63;
+	while (size < 2 * pairCount()) {
+		size *= 2;
+		this->slotShift--;
+	}
+	const Slot empty = {0, 0, 0.0f};
+	this->slots.assign(size, empty);
+
+	for (int row = 0; row < rows; row++)
+	{
+		const unsigned int id = this->ingredients[row].getId();
+		for (uint32_t e = this->offsets[row]; e < this->offsets[row + 1]; e++)
+		{
+			const Edge& edge = this->edges[e];
+			if (edge.partner < id) continue;
+			Slot& slot = this->slots[slotOf(pairKey(id, edge.partner))];
+			slot.key = pairKey(id, edge.partner);
+			slot.effect = edge.effect;
+			slot.value = edge.value;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+float CompatibilityOracle::pairValue(const unsigned int id1,
+									 const unsigned int id2) const
+{
+	return this->slots[slotOf(pairKey(id1, id2))].value;
+}
+
+//------------------------------------------------------------------------------
+unsigned int CompatibilityOracle::sharedEffect(const unsigned int id1,
+											   const unsigned int id2) const
+{
+	return this->slots[slotOf(pairKey(id1, id2))].effect;
+}
+
+//------------------------------------------------------------------------------
+const CompatibilityOracle::Edge* CompatibilityOracle::partnersBegin
+	(const unsigned int id) const
+{
+	if (id >= this->rowsById.size() || this->rowsById[id] < 0)
+		return nullptr;
+	return this->edges.data() + this->offsets[this->rowsById[id]];
+}
+
+//------------------------------------------------------------------------------
+const CompatibilityOracle::Edge* CompatibilityOracle::partnersEnd
+	(const unsigned int id) const
+{
+	if (id >= this->rowsById.size() || this->rowsById[id] < 0)
+		return nullptr;
+	return this->edges.data() + this->offsets[this->rowsById[id] + 1];
+}
+
+//------------------------------------------------------------------------------
+float CompatibilityOracle::bestPairValue(const unsigned int id) const
+{
+	if (id >= this->rowsById.size() || this->rowsById[id] < 0)
+		return 0.0f;
+	return this->bestValues[this->rowsById[id]];
+}
+
+//------------------------------------------------------------------------------
+size_t CompatibilityOracle::pairCount() const
+{
+	return this->edges.size() / 2;
+}
+
+//------------------------------------------------------------------------------
+double CompatibilityOracle::pairValueBound(const Alchemist& alchemist) const
+{
+	double bound = 0.0;
+	for (size_t row = 0; row < this->ingredients.size(); row++)
+		bound += alchemist.stockOfId(this->ingredients[row].getId())
+			* this->bestValues[row] / 2.0;
+	return bound;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//                              Private Methods
+//
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+// Multiplicative hashing on the key's top bits.
+size_t CompatibilityOracle::slotOf(const uint64_t key) const
+{
+	const size_t mask = this->slots.size() - 1;
+	size_t i = (key * 0x9e3779b97f4a7c15ULL) >> this->slotShift;
+	while (this->slots[i].key != 0 && this->slots[i].key != key)
+		i = (i + 1) & mask;
+	return i;
+}
+
+//------------------------------------------------------------------------------
+// Walk the rows listed under each of the row's effects, keeping the rarest
+// shared effect per partner, then reset the scratch values it touched.
+void CompatibilityOracle::findPartners
+	(const int row, const vector<vector<uint32_t> >& rowsByEffect,
+	 vector<float>& values, vector<uint32_t>& effects, vector<Edge>& out) const
+{
+	for (const StatusEffect& effect : this->ingredients[row])
+	{
+		const float rarity = effect.getRarity();
+		for (const uint32_t partner : rowsByEffect[effect.getId()])
+		{
+			if (partner == uint32_t(row)) continue;
+			if (effects[partner] == 0 || values[partner] < rarity) {
+				if (effects[partner] == 0) {
+					const Edge edge = {partner, 0, 0.0f};
+					out.push_back(edge);
+				}
+				values[partner] = rarity;
+				effects[partner] = effect.getId();
+			}
+		}
+	}
+
+	// Fill in the edges, by partner id, clearing the scratch as it goes.
+	for (Edge& edge : out) {
+		const uint32_t partner = edge.partner;
+		edge.effect = effects[partner];
+		edge.value = values[partner];
+		edge.partner = this->ingredients[partner].getId();
+		effects[partner] = 0;
+		values[partner] = 0.0f;
+	}
+	sort(out.begin(), out.end(), [](const Edge& lhs, const Edge& rhs)
+		 { return lhs.partner < rhs.partner; });
+}
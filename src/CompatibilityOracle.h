@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        CompatibilityOracle.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (fixed width integers)
+ *
+ * The true compatibility of every pair of ingredients in a world: which pairs
+ * share a status effect, and the value of the potion each pair makes - the
+ * rarity of the rarest effect they share. It uses the ingredients' real
+ * effects, known or not, so it's an oracle for evaluating strategies rather
+ * than something an alchemist could know.
+ *
+ * The pairs are held as sparse adjacency lists in compressed sparse row form,
+ * each row's partners in id order, with a hash table over the same edges for
+ * O(1) lookup of a pair. Building lists the ingredients under each effect,
+ * then finds each ingredient's partners from those lists, split across the
+ * pool's threads.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Ingredient.h"
+#include "ThreadPool.h"
+
+class Alchemist;
+
+
+class CompatibilityOracle
+{
+public:
+	// A pair of compatible ingredients, seen from one of them.
+	struct Edge
+	{
+		uint32_t partner;
+
+		// The rarest effect the pair share, and its rarity.
+		uint32_t effect;
+		float value;
+	};
+
+private:
+	struct Slot
+	{
+		// The pair's ids, smaller in the high half. 0 marks an empty slot.
+		uint64_t key;
+		uint32_t effect;
+		float value;
+	};
+
+	// The ingredients, by row, and each id's row or -1.
+	std::vector<Ingredient> ingredients;
+	std::vector<int> rowsById;
+
+	// Row r's edges are edges[offsets[r]] to edges[offsets[r + 1]].
+	std::vector<uint32_t> offsets;
+	std::vector<Edge> edges;
+
+	// The value of each row's most valuable edge.
+	std::vector<float> bestValues;
+
+	// An open-addressed hash table of the edges, each pair once, probed
+	// linearly. Its size is a power of two, at most half full.
+	std::vector<Slot> slots;
+	int slotShift;
+
+	// Returns the slot holding the key, or the empty slot where it would go.
+	size_t slotOf(const uint64_t key) const;
+
+	// Finds one row's partners, using the scratch values indexed by row.
+	void findPartners(const int row,
+					  const std::vector<std::vector<uint32_t> >& rowsByEffect,
+					  std::vector<float>& values, std::vector<uint32_t>& effects,
+					  std::vector<Edge>& out) const;
+
+public:
+	// Builds the oracle for the ingredients, on the pool's threads.
+	CompatibilityOracle(const std::vector<Ingredient>& ingredients,
+						ThreadPool& pool);
+
+	// Returns the value of the potion the pair make, or 0 if they share no
+	// effect or either isn't in the oracle.
+	float pairValue(const unsigned int id1, const unsigned int id2) const;
+
+	// Returns the id of the rarest effect the pair share, or 0.
+	unsigned int sharedEffect(const unsigned int id1,
+							  const unsigned int id2) const;
+
+	// The ingredient's compatible partners, in id order. Both are null if the
+	// ingredient isn't in the oracle.
+	const Edge* partnersBegin(const unsigned int id) const;
+	const Edge* partnersEnd(const unsigned int id) const;
+
+	// The value of the ingredient's best pair, or 0.
+	float bestPairValue(const unsigned int id) const;
+
+	// The number of compatible pairs.
+	size_t pairCount() const;
+
+	// An upper bound on the value the alchemist could brew from its stock in
+	// two-ingredient potions: each ingredient at best takes half of its best
+	// pair's value.
+	double pairValueBound(const Alchemist& alchemist) const;
+};
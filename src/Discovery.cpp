@@ -13,14 +13,15 @@
 using namespace std;
 
 //------------------------------------------------------------------------------
-Discovery::Discovery()
+Discovery::Discovery() :
+count(0), potionValue(0.0)
 {
 }
 
 //------------------------------------------------------------------------------
 int Discovery::findingsCount() const
 {
-	return this->findings.size();
+	return this->count;
 }
 
 //------------------------------------------------------------------------------
@@ -28,7 +29,9 @@ int Discovery::findingsCount() const
 void Discovery::addFinding
 	(const Ingredient & ingredient, const StatusEffect & effect)
 {
-	this->findings.push_back(Finding(ingredient, effect));
+	if (this->count == sMaxFindings)
+		throw length_error("Discovery::addFinding() - too many findings.");
+	this->findings[this->count++] = Finding(ingredient, effect);
 }
 
 //------------------------------------------------------------------------------
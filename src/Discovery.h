@@ -8,6 +8,9 @@
  * A container for information uncovered by the alchemist upon combining 
  * ingredients. This includes the association of a status effect with an 
  * ingredient and the value of the created potion.
+ *
+ * Findings are held inline, up to the most a three ingredient potion can
+ * reveal, so returning a Discovery never allocates.
  ******************************************************************************/
 
 #pragma once
@@ -21,11 +24,18 @@ class Discovery
 		Ingredient ingredient;
 		StatusEffect effect;
 		
+		Finding() {}
 		Finding(const Ingredient& i, const StatusEffect& e) :
 			ingredient(i), effect(e) {}
 	};
 
-	std::vector<Finding> findings;
+public:
+	// Each effect of each of three ingredients can be found at most once.
+	static const int sMaxFindings = 3 * Ingredient::sMaxEffects;
+
+private:
+	Finding findings[sMaxFindings];
+	int count;
 	
 public:
 	Discovery();
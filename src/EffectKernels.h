@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        EffectKernels.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (lambdas, static_assert)
+ *
+ * The inner loops over an ingredient's effects, as templates on the number of
+ * effects N. Each loop is unrolled at compile time by recursive templates, so
+ * an N-effect build runs straight-line code with no loop counters, and the
+ * matching kernel compares every pair of effects without branching.
+ *
+ * Ingredients have Ingredient::sMaxEffects effects, set when building, and the
+ * kernels are used with that count.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <limits>
+#include "StatusEffect.h"
+
+
+namespace EffectKernels
+{
+	// Calls f(I), f(I + 1) ... f(N - 1), each index a constant once inlined.
+	template<int I, int N> struct Unroll
+	{
+		template<class F> static void each(const F& f)
+		{
+			f(I);
+			Unroll<I + 1, N>::each(f);
+		}
+	};
+
+	template<int N> struct Unroll<N, N>
+	{
+		template<class F> static void each(const F&) {}
+	};
+
+	//--------------------------------------------------------------------------
+	// Returns a mask with bit i set if effect i of a is also one of b's.
+	template<int N>
+	unsigned int sharedMask(const StatusEffect* a, const StatusEffect* b)
+	{
+		static_assert(N >= 1 && N <= 32, "The mask holds at most 32 effects.");
+
+		unsigned int idsA[N], idsB[N];
+		Unroll<0, N>::each([&](const int i) {
+			idsA[i] = a[i].getId();
+			idsB[i] = b[i].getId();
+		});
+
+		unsigned int mask = 0;
+		Unroll<0, N>::each([&](const int i) {
+			unsigned int found = 0;
+			Unroll<0, N>::each([&](const int j) {
+				found |= idsA[i] == idsB[j];
+			});
+			mask |= found << i;
+		});
+		return mask;
+	}
+
+	//--------------------------------------------------------------------------
+	// Sums the effects' rarities, in order, and finds the two greatest.
+	template<int N>
+	void rarities(const StatusEffect* effects, double& sum, double& rarest,
+				  double& second)
+	{
+		static_assert(N >= 2, "An ingredient needs two effects for a best "
+			"potion.");
+
+		const std::vector<double>& table = StatusEffect::rarityTable();
+		sum = 0.0;
+		rarest = second = std::numeric_limits<double>::lowest();
+		Unroll<0, N>::each([&](const int i) {
+			const double rarity = table[effects[i].getId()];
+			sum += rarity;
+			if (rarity > rarest) {
+				second = rarest;
+				rarest = rarity;
+			}
+			else if (rarity > second)
+				second = rarity;
+		});
+	}
+}
@@ -0,0 +1,131 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        ForagingPipeline.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<thread>, <atomic>, <functional>)
+ ******************************************************************************/
+
+#include "ForagingPipeline.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+#include "SpscRing.h"
+#include "WeightedRandomizedStack.h"
+#include "Trace.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+ForagingPipeline::ForagingPipeline(const int batchSize, const int depth) :
+batchSize(batchSize), depth(depth)
+{
+	if (batchSize <= 0 || depth <= 0)
+		throw invalid_argument("ForagingPipeline() - the batch size and depth "
+			"must be positive.");
+}
+
+//------------------------------------------------------------------------------
+// The forager fills empty batches and pushes them to the full ring; the brewer
+// pops them, brews, and returns them empty. Either side waiting yields its
+// core. The forager marks the end, or a failure, with the done flag, which it
+// sets after its last push - so once the brewer sees it, an empty ring means
+// nothing more is coming.
+ForagingPipeline::Report ForagingPipeline::run
+	(Alchemist& alchemist, const long long count, const Strategy& strategy,
+	 RandomStream& random) const
+{
+	// Fix the garden before the forager starts, as brewing changes the
+	// alchemist.
+	WeightedRandomizedStack<uint32_t> garden;
+	for (const Ingredient& ingredient : alchemist.allKnownIngredients())
+		garden.push(ingredient.getId(), ingredient.getForageWeight());
+
+	SpscRing<Batch> full(this->depth);
+	SpscRing<Batch> empty(this->depth);
+	for (size_t i = 0; i < empty.capacity(); i++) {
+		Batch batch;
+		batch.reserve(this->batchSize);
+		empty.tryPush(batch);
+	}
+
+	atomic<bool> done(false);
+	atomic<bool> stopping(false);
+	exception_ptr forageFailure;
+	Report report = {0.0, 0, 0, 0};
+
+	const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	thread forager([&]() {
+		Trace::nameThread("forager");
+		POTIONS_PHASE("stream forage");
+		try {
+			Batch batch;
+			for (long long left = count; left > 0 && !stopping.load(); )
+			{
+				if (!empty.tryPop(batch)) {
+					report.foragerWaits++;
+					this_thread::yield();
+					continue;
+				}
+
+				const long long size = min<long long>(left, this->batchSize);
+				batch.clear();
+				for (long long i = 0; i < size; i++)
+					batch.push_back(garden.peak(random));
+				left -= size;
+
+				while (!full.tryPush(batch) && !stopping.load()) {
+					report.foragerWaits++;
+					this_thread::yield();
+				}
+			}
+		}
+		catch (...) {
+			forageFailure = current_exception();
+		}
+		done.store(true, memory_order_release);
+	});
+
+	exception_ptr brewFailure;
+	try {
+		POTIONS_PHASE("stream brew");
+		Batch batch;
+		for (;;)
+		{
+			const bool finished = done.load(memory_order_acquire);
+			if (!full.tryPop(batch)) {
+				if (finished)
+					break;
+				report.brewerWaits++;
+				this_thread::yield();
+				continue;
+			}
+
+			alchemist.restock(batch);
+			strategy(alchemist, batch);
+			report.batches++;
+
+			// The empty ring has room for every batch, so this can't fail.
+			empty.tryPush(batch);
+		}
+	}
+	catch (...) {
+		brewFailure = current_exception();
+		stopping.store(true);
+	}
+	forager.join();
+
+	const chrono::duration<double> elapsed =
+		chrono::steady_clock::now() - start;
+	report.seconds = elapsed.count();
+
+	if (forageFailure)
+		rethrow_exception(forageFailure);
+	if (brewFailure)
+		rethrow_exception(brewFailure);
+	return report;
+}
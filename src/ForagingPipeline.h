@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        ForagingPipeline.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<thread>, <atomic>, <functional>)
+ *
+ * Streams foraging into brewing. A forager thread draws ingredients from the
+ * alchemist's garden in batches and passes them through a bounded ring to the
+ * brewing thread, which adds each batch to stock and hands it to a strategy
+ * that reacts to the new arrivals. Sampling and brewing overlap, and stock
+ * never has to exist all at once.
+ *
+ * Batches are recycled through a second ring back to the forager, so the
+ * memory held by the pipeline is fixed by its batch size and depth however
+ * many ingredients are foraged. When the ring is full the forager waits for
+ * the brewer, and when it's empty the brewer waits for the forager.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include "Alchemist.h"
+#include "Random.h"
+
+
+class ForagingPipeline
+{
+public:
+	// The ids of a batch of foraged ingredients, one per ingredient.
+	typedef std::vector<uint32_t> Batch;
+
+	// Reacts to a batch that's just been added to the alchemist's stock.
+	typedef std::function<void(Alchemist&, const Batch&)> Strategy;
+
+	// How a run went.
+	struct Report
+	{
+		double seconds;
+		int batches;
+
+		// The times each thread found the ring full or empty, and waited.
+		long long foragerWaits;
+		long long brewerWaits;
+	};
+
+private:
+	int batchSize;
+	int depth;
+
+public:
+	// Builds a pipeline passing batches of the given size, with at most depth
+	// batches between the threads. Throws invalid_argument unless both are
+	// positive.
+	explicit ForagingPipeline(const int batchSize = 256, const int depth = 16);
+
+	// Forages count ingredients from the alchemist's garden on a new thread,
+	// while the calling thread adds each batch to the alchemist's stock and
+	// calls the strategy. The garden is fixed by the ingredients known at the
+	// start, and the random stream is used only by the forager. The first
+	// exception thrown by either side is rethrown once both have stopped.
+	Report run(Alchemist& alchemist, const long long count,
+			   const Strategy& strategy,
+			   RandomStream& random = RandomStream::local()) const;
+};
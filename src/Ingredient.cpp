@@ -9,6 +9,8 @@
 #include "Ingredient.h"
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include "EffectKernels.h"
 
 using namespace std;
 
@@ -16,20 +18,25 @@ using namespace std;
 // Initialize static members
 const Ingredient Ingredient::nullValue = Ingredient();
 unsigned int Ingredient::sNextId = 1; // 0 is reserved for invalids.
+vector<Ingredient> Ingredient::sExistingIngredients = vector<Ingredient>(1);
+vector<double> Ingredient::sRarities = vector<double>(1, 0.0);
+vector<double> Ingredient::sForageWeights = vector<double>(1, 0.0);
+vector<double> Ingredient::sBestPotionValues = vector<double>(1, 0.0);
 
 //------------------------------------------------------------------------------
 // Default constructor - initializes with invalid id. Only used by containers.
 Ingredient::Ingredient() :
-id(0), effects(sMaxEffects)
+id(0)
 {
 }
 
 //------------------------------------------------------------------------------
 // Private constructor - assign all constant members.
-Ingredient::Ingredient(const unsigned int id,
-					   const vector<StatusEffect>& effects) :
-id(id), effects(effects)
+Ingredient::Ingredient(const unsigned int id, const StatusEffect* effects) :
+id(id)
 {
+	for (int i = 0; i < sMaxEffects; i++)
+		this->effects[i] = effects[i];
 }
 
 //------------------------------------------------------------------------------
@@ -42,6 +49,12 @@ Ingredient& Ingredient::operator=(const Ingredient& rhs)
 	return *this;
 }
 
+//------------------------------------------------------------------------------
+unsigned int Ingredient::getId() const
+{
+	return this->id;
+}
+
 //------------------------------------------------------------------------------
 // Subscript operator - StatusEffects are readonly
 const StatusEffect& Ingredient::operator[](const int i) const
@@ -51,24 +64,31 @@ const StatusEffect& Ingredient::operator[](const int i) const
 
 //------------------------------------------------------------------------------
 // Iterators - enabling c++11 range-based loops
-vector<StatusEffect>::const_iterator Ingredient::begin() const
+const StatusEffect* Ingredient::begin() const
 {
-	return this->effects.begin();
+	return this->effects;
 }
 	
-vector<StatusEffect>::const_iterator  Ingredient::end() const
+const StatusEffect* Ingredient::end() const
 {
-	return this->effects.end();
+	return this->effects + sMaxEffects;
 }
 
 //------------------------------------------------------------------------------
-// Calculate rarity - takes the average rarity of it's status effects
-double Ingredient::calculateRarity() const
+// Derived values - looked up in the tables filled by newIngredient()
+double Ingredient::getRarity() const
 {
-	double average = 0.0;
-	for (int i = 0; i < sMaxEffects; i++)
-		average += this->effects[i].getRarity();
-	return average / sMaxEffects;
+	return sRarities[this->id];
+}
+
+double Ingredient::getForageWeight() const
+{
+	return sForageWeights[this->id];
+}
+
+double Ingredient::getBestPotionValue() const
+{
+	return sBestPotionValues[this->id];
 }
 
 //------------------------------------------------------------------------------
@@ -87,21 +107,99 @@ bool Ingredient::operator<(const Ingredient& rhs) const
 
 //------------------------------------------------------------------------------
 // Static constructor - makes sure status effects and id are unique.
-Ingredient Ingredient::newIngredient()
+Ingredient Ingredient::newIngredient(RandomStream& random)
 {
-	// Can only make a new ingredient if at least 4 status effects exist
+	// Can only make a new ingredient if at least sMaxEffects effects exist
 	if (StatusEffect::total() < sMaxEffects)
 		throw logic_error("Cannot discover new ingredient because less "
 			"than sMaxEffects status effects exist to choose from");
 	
-	// Copy the status effects stack and pop the required number
-	WeightedRandomizedStack<StatusEffect> existingEffects = 
-		StatusEffect::getExistingEffectsStack();
-	
-	vector<StatusEffect> effects;
+	// Draw effects by rarity, rejecting repeats. This is equivalent to
+	// popping from a copy of the existing effects stack, without the copy.
+	StatusEffect effects[sMaxEffects];
 	for (int i = 0; i < sMaxEffects; i++)
-		effects.push_back(existingEffects.pop());
+	{
+		StatusEffect* const end = effects + i;
+		do effects[i] = StatusEffect::randomStatusEffect(random);
+		while (find(effects, end, effects[i]) != end);
+	}
+	
+	return newIngredient(effects);
+}
+
+//------------------------------------------------------------------------------
+// Static constructor - records the derived values against a new id.
+Ingredient Ingredient::newIngredient(const StatusEffect* effects)
+{
+	// Calculate rarity - takes the average rarity of it's status effects. The
+	// best potion brews the two rarest effects together.
+	double average, rarest, second;
+	EffectKernels::rarities<sMaxEffects>(effects, average, rarest, second);
+	average /= sMaxEffects;
+	
+	// Record the derived values against the new id.
+	sRarities.push_back(average);
+	sForageWeights.push_back(1.0 / average);
+	sBestPotionValues.push_back(rarest + second);
 	
 	// Create a new ingredient from these effects and increment the next id.
-	return Ingredient(sNextId++, effects);
+	sExistingIngredients.push_back(Ingredient(sNextId++, effects));
+	return sExistingIngredients.back();
+}
+
+//------------------------------------------------------------------------------
+// Static method - look up an existing ingredient by id
+const Ingredient& Ingredient::fromId(const unsigned int id)
+{
+	if (id == 0 || id >= sExistingIngredients.size())
+		throw out_of_range("Ingredient::fromId() - no ingredient has that id.");
+	return sExistingIngredients[id];
+}
+
+//------------------------------------------------------------------------------
+// Static methods - read-only access to the derived value tables
+const vector<double>& Ingredient::rarityTable()
+{
+	return sRarities;
+}
+
+const vector<double>& Ingredient::forageWeightTable()
+{
+	return sForageWeights;
+}
+
+const vector<double>& Ingredient::bestPotionValueTable()
+{
+	return sBestPotionValues;
+}
+
+//------------------------------------------------------------------------------
+MemoryUsage Ingredient::registryMemoryUsage()
+{
+	MemoryUsage usage;
+	usage.add("ingredients", MemoryUsage::heapBytes(sExistingIngredients));
+	usage.add("derivedValues", MemoryUsage::heapBytes(sRarities)
+			  + MemoryUsage::heapBytes(sForageWeights)
+			  + MemoryUsage::heapBytes(sBestPotionValues));
+	return usage;
+}
+
+//------------------------------------------------------------------------------
+unsigned int Ingredient::registryMark()
+{
+	return sNextId;
+}
+
+//------------------------------------------------------------------------------
+// Static method - the derived value tables shrink with the registry.
+void Ingredient::releaseRegistry(const unsigned int mark)
+{
+	if (mark == 0 || mark > sNextId)
+		throw out_of_range("Ingredient::releaseRegistry() - the mark is ahead "
+			"of the registry.");
+	sExistingIngredients.resize(mark);
+	sRarities.resize(mark);
+	sForageWeights.resize(mark);
+	sBestPotionValues.resize(mark);
+	sNextId = mark;
 }
\ No newline at end of file
@@ -6,44 +6,78 @@
  * Standard:    C++11 (Uses array initializer list)
  *
  * Ingredient instances are created via the static method newIngredient(). Each
- * returned instance has a unique id and 4 randomly assigned StatusEffects, all
- * of which are immutable. An ingredient's rarity - used to determine how likely
- * it is to be foraged by an alchemist - is calculated as the average rarity of
- * its status effects.
+ * returned instance has a unique id and sMaxEffects randomly assigned
+ * StatusEffects, all of which are immutable. An ingredient's rarity - used to
+ * determine how likely it is to be foraged by an alchemist - is calculated as
+ * the average rarity of its status effects.
+ *
+ * An ingredient's derived values (rarity, forage weight and best potion value)
+ * are computed once by newIngredient() and stored in static tables indexed by
+ * id, so hot loops read them from contiguous memory.
+ *
+ * The number of effects is fixed when building, by defining POTIONS_EFFECTS
+ * (make EFFECTS=N), from 2 to 8 - 4 by default. The loops over effects are
+ * unrolled for that count by the kernels in EffectKernels.h.
  ******************************************************************************/
 
 #pragma once
 #include "StatusEffect.h"
+#include "MemoryUsage.h"
+
+#ifndef POTIONS_EFFECTS
+#define POTIONS_EFFECTS 4
+#endif
+
+// Best potions need two effects, and the ingredient table's known-effect masks
+// hold eight.
+static_assert(POTIONS_EFFECTS >= 2 && POTIONS_EFFECTS <= 8,
+			  "POTIONS_EFFECTS must be from 2 to 8.");
 
 class Ingredient
 {
 	// Used for sorting in containers
 	unsigned int id;
 	
+public:
+	// The number of status effects every ingredient has.
+	static const int sMaxEffects = POTIONS_EFFECTS;
+
+private:
 	// The potential status effects of the ingredient when combined with others.
-	static const int sMaxEffects = 4;
-	std::vector<StatusEffect> effects;
+	// Held inline, so copying an ingredient never allocates.
+	StatusEffect effects[sMaxEffects];
 	
 	// Only used by static method - newIngredient()
-	Ingredient(const unsigned int id,
-			   const std::vector<StatusEffect>& effects);
+	Ingredient(const unsigned int id, const StatusEffect* effects);
 
 public:
+	
 	// Default constructor - creates invalid id, only used by containers.
 	Ingredient();
 	static const Ingredient nullValue;
 	
 	Ingredient& operator=(const Ingredient& rhs);
 	
+	// Returns the ingredient's unique id.
+	unsigned int getId() const;
+	
 	// Status effects are readonly, and accessed via the subscript operator.
 	const StatusEffect& operator[](const int i) const;
 	
 	// Also accessible via iterators (to allow range-based loops)
-	std::vector<StatusEffect>::const_iterator begin() const;
-	std::vector<StatusEffect>::const_iterator end() const;
+	const StatusEffect* begin() const;
+	const StatusEffect* end() const;
 	
 	// Returns the average rarity of the ingredient's status effects.
-	double calculateRarity() const;
+	double getRarity() const;
+	
+	// Returns the likelihood of the ingredient being foraged - the
+	// reciprocal of its rarity.
+	double getForageWeight() const;
+	
+	// Returns the most any potion using the ingredient can be worth - the sum
+	// of its two rarest effects, as brewed with two other ingredients.
+	double getBestPotionValue() const;
 	
 	// Comparison operator used for list and map sorting via ids.
 	bool operator==(const Ingredient& rhs) const;
@@ -57,10 +91,43 @@ public:
 
 	// Construct via static method so each Ingredient has a unique id.
 	// Status effects are assigned randomly according to rarity.
-	static Ingredient newIngredient();
+	static Ingredient newIngredient
+		(RandomStream& random = RandomStream::local());
+	
+	// As above, but with the given effects, which must all differ.
+	static Ingredient newIngredient(const StatusEffect* effects);
+	
+	// Returns the existing ingredient with the id.
+	// Throws out_of_range if no such ingredient exists.
+	static const Ingredient& fromId(const unsigned int id);
+	
+	// Derived value tables, indexed by ingredient id. Entry 0 is the invalid
+	// ingredient, with values of 0.
+	static const std::vector<double>& rarityTable();
+	static const std::vector<double>& forageWeightTable();
+	static const std::vector<double>& bestPotionValueTable();
+	
+	// The memory held by the registry of existing ingredients and its tables.
+	static MemoryUsage registryMemoryUsage();
+	
+	// The id the next ingredient will take, as a mark to release back to.
+	static unsigned int registryMark();
+	
+	// Forgets every ingredient made since the mark, so their ids are reused.
+	// Those ingredients mustn't be used again. Throws out_of_range if the mark
+	// is ahead of the registry.
+	static void releaseRegistry(const unsigned int mark);
 	
 private:
 	// Used for assigning unique ids.
 	static unsigned int sNextId;
+	
+	// Every ingredient created, indexed by id.
+	static std::vector<Ingredient> sExistingIngredients;
+	
+	// Derived values of every ingredient, indexed by id.
+	static std::vector<double> sRarities;
+	static std::vector<double> sForageWeights;
+	static std::vector<double> sBestPotionValues;
 };
 
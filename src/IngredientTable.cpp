@@ -0,0 +1,392 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        IngredientTable.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (fixed width integers, thread_local)
+ ******************************************************************************/
+
+#include "IngredientTable.h"
+#include <algorithm>
+#include <cstring>
+#include "MemoryUsage.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define POTIONS_X86_SIMD
+#endif
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// The known effects of a query ingredient, and pointers to the table columns,
+// in the form the kernels consume them.
+namespace
+{
+	struct Query
+	{
+		int count;
+		uint32_t ids[Ingredient::sMaxEffects];
+		float rarities[Ingredient::sMaxEffects];
+	};
+
+	struct Columns
+	{
+		const uint32_t* effectIds[Ingredient::sMaxEffects];
+		const uint8_t* knownMasks;
+		const uint32_t* stock;
+		int size;
+	};
+
+	//--------------------------------------------------------------------------
+	// Scalar kernel - scores rows [begin, end). Also finishes the SIMD kernels.
+	void scoreScalar(const Query& q, const Columns& c, const int begin,
+					 float* scores)
+	{
+		for (int j = begin; j < c.size; j++)
+		{
+			float best = 0.0f;
+			if (c.stock[j] > 0)
+				for (int b = 0; b < Ingredient::sMaxEffects; b++)
+				{
+					if (!(c.knownMasks[j] & (1 << b))) continue;
+					for (int a = 0; a < q.count; a++)
+						if (c.effectIds[b][j] == q.ids[a])
+							best = max(best, q.rarities[a]);
+				}
+			scores[j] = best;
+		}
+	}
+
+#ifdef POTIONS_X86_SIMD
+#ifdef __SSE2__
+	//--------------------------------------------------------------------------
+	// SSE2 kernel - scores four rows at a time.
+	void scoreSSE2(const Query& q, const Columns& c, float* scores)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i ids[Ingredient::sMaxEffects];
+		__m128 rarities[Ingredient::sMaxEffects];
+		for (int a = 0; a < q.count; a++) {
+			ids[a] = _mm_set1_epi32(q.ids[a]);
+			rarities[a] = _mm_set1_ps(q.rarities[a]);
+		}
+
+		int j = 0;
+		for (; j + 4 <= c.size; j += 4)
+		{
+			// Widen four mask bytes to four 32 bit lanes.
+			uint32_t maskBytes;
+			memcpy(&maskBytes, c.knownMasks + j, sizeof(maskBytes));
+			const __m128i masks = _mm_unpacklo_epi16(
+				_mm_unpacklo_epi8(_mm_cvtsi32_si128(maskBytes), zero), zero);
+
+			__m128 best = _mm_setzero_ps();
+			for (int b = 0; b < Ingredient::sMaxEffects; b++)
+			{
+				const __m128i bit = _mm_set1_epi32(1 << b);
+				const __m128i known =
+					_mm_cmpeq_epi32(_mm_and_si128(masks, bit), bit);
+				const __m128i slot = _mm_loadu_si128(
+					reinterpret_cast<const __m128i*>(c.effectIds[b] + j));
+				for (int a = 0; a < q.count; a++) {
+					const __m128i match =
+						_mm_and_si128(known, _mm_cmpeq_epi32(slot, ids[a]));
+					best = _mm_max_ps(best,
+						_mm_and_ps(_mm_castsi128_ps(match), rarities[a]));
+				}
+			}
+
+			// Zero the lanes of rows that are out of stock.
+			const __m128i empty = _mm_cmpeq_epi32(_mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(c.stock + j)), zero);
+			best = _mm_andnot_ps(_mm_castsi128_ps(empty), best);
+			_mm_storeu_ps(scores + j, best);
+		}
+		scoreScalar(q, c, j, scores);
+	}
+#endif
+
+	//--------------------------------------------------------------------------
+	// AVX2 kernel - scores eight rows at a time. Only called once the
+	// processor is known to support AVX2.
+	__attribute__((target("avx2")))
+	void scoreAVX2(const Query& q, const Columns& c, float* scores)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		__m256i ids[Ingredient::sMaxEffects];
+		__m256 rarities[Ingredient::sMaxEffects];
+		for (int a = 0; a < q.count; a++) {
+			ids[a] = _mm256_set1_epi32(q.ids[a]);
+			rarities[a] = _mm256_set1_ps(q.rarities[a]);
+		}
+
+		int j = 0;
+		for (; j + 8 <= c.size; j += 8)
+		{
+			// Widen eight mask bytes to eight 32 bit lanes.
+			const __m256i masks = _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+				reinterpret_cast<const __m128i*>(c.knownMasks + j)));
+
+			__m256 best = _mm256_setzero_ps();
+			for (int b = 0; b < Ingredient::sMaxEffects; b++)
+			{
+				const __m256i bit = _mm256_set1_epi32(1 << b);
+				const __m256i known =
+					_mm256_cmpeq_epi32(_mm256_and_si256(masks, bit), bit);
+				const __m256i slot = _mm256_loadu_si256(
+					reinterpret_cast<const __m256i*>(c.effectIds[b] + j));
+				for (int a = 0; a < q.count; a++) {
+					const __m256i match =
+						_mm256_and_si256(known, _mm256_cmpeq_epi32(slot, ids[a]));
+					best = _mm256_max_ps(best,
+						_mm256_and_ps(_mm256_castsi256_ps(match), rarities[a]));
+				}
+			}
+
+			// Zero the lanes of rows that are out of stock.
+			const __m256i empty = _mm256_cmpeq_epi32(_mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(c.stock + j)), zero);
+			best = _mm256_andnot_ps(_mm256_castsi256_ps(empty), best);
+			_mm256_storeu_ps(scores + j, best);
+		}
+		scoreScalar(q, c, j, scores);
+	}
+
+	//--------------------------------------------------------------------------
+	// Checked once - whether the AVX2 kernel can be used.
+	bool hasAVX2()
+	{
+		static const bool supported = __builtin_cpu_supports("avx2");
+		return supported;
+	}
+#endif
+
+	//--------------------------------------------------------------------------
+	// Orders partners most valuable first, breaking ties by row.
+	bool morePromising(const IngredientTable::Partner& lhs,
+					   const IngredientTable::Partner& rhs)
+	{
+		if (lhs.value != rhs.value)
+			return lhs.value > rhs.value;
+		return lhs.row < rhs.row;
+	}
+
+	// Reused score buffer, so searches don't allocate.
+	thread_local vector<float> tScores;
+}
+
+//------------------------------------------------------------------------------
+IngredientTable::IngredientTable()
+{
+}
+
+//------------------------------------------------------------------------------
+int IngredientTable::size() const
+{
+	return this->ingredients.size();
+}
+
+//------------------------------------------------------------------------------
+// Append a row to every column. Nothing is known and nothing is stocked.
+int IngredientTable::addIngredient(const Ingredient& ingredient)
+{
+	const int existing = rowOf(ingredient);
+	if (existing >= 0)
+		return existing;
+
+	const int row = size();
+	const unsigned int id = ingredient.getId();
+	if (id >= this->rowsById.size())
+		this->rowsById.resize(id + 1, -1);
+	this->rowsById[id] = row;
+
+	this->ingredients.push_back(ingredient);
+	for (int b = 0; b < Ingredient::sMaxEffects; b++) {
+		this->effectIds[b].push_back(ingredient[b].getId());
+		this->effectRarities[b].push_back(ingredient[b].getRarity());
+	}
+	this->knownMasks.push_back(0);
+	this->stock.push_back(0);
+
+	return row;
+}
+
+//------------------------------------------------------------------------------
+int IngredientTable::rowOf(const Ingredient& ingredient) const
+{
+	return rowOfId(ingredient.getId());
+}
+
+int IngredientTable::rowOfId(const unsigned int id) const
+{
+	if (id >= this->rowsById.size())
+		return -1;
+	return this->rowsById[id];
+}
+
+//------------------------------------------------------------------------------
+const Ingredient& IngredientTable::getIngredient(const int row) const
+{
+	return this->ingredients[row];
+}
+
+//------------------------------------------------------------------------------
+size_t IngredientTable::getBytesHeld() const
+{
+	size_t bytes = MemoryUsage::heapBytes(this->ingredients)
+		+ MemoryUsage::heapBytes(this->rowsById)
+		+ MemoryUsage::heapBytes(this->knownMasks)
+		+ MemoryUsage::heapBytes(this->stock);
+	for (int b = 0; b < Ingredient::sMaxEffects; b++)
+		bytes += MemoryUsage::heapBytes(this->effectIds[b])
+			+ MemoryUsage::heapBytes(this->effectRarities[b]);
+	return bytes;
+}
+
+//------------------------------------------------------------------------------
+unsigned int IngredientTable::getStock(const int row) const
+{
+	return this->stock[row];
+}
+
+void IngredientTable::setStock(const int row, const unsigned int count)
+{
+	this->stock[row] = count;
+}
+
+//------------------------------------------------------------------------------
+// Set the bit of whichever slot holds the effect.
+void IngredientTable::markEffectKnown(const int row, const StatusEffect& effect)
+{
+	for (int b = 0; b < Ingredient::sMaxEffects; b++)
+		if (this->effectIds[b][row] == effect.getId())
+			this->knownMasks[row] |= 1 << b;
+}
+
+//------------------------------------------------------------------------------
+uint8_t IngredientTable::getKnownMask(const int row) const
+{
+	return this->knownMasks[row];
+}
+
+//------------------------------------------------------------------------------
+// Check the bit of whichever slot holds the effect.
+bool IngredientTable::isEffectKnown(const int row, const StatusEffect& effect)
+	const
+{
+	for (int b = 0; b < Ingredient::sMaxEffects; b++)
+		if (this->effectIds[b][row] == effect.getId())
+			return (this->knownMasks[row] & (1 << b)) != 0;
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Compare every known slot of one row against every known slot of the other.
+uint32_t IngredientTable::rarestSharedKnownEffect
+	(const int row1, const int row2) const
+{
+	uint32_t rarest = 0;
+	float rarity = 0.0f;
+	for (int a = 0; a < Ingredient::sMaxEffects; a++)
+	{
+		if (!(this->knownMasks[row1] & (1 << a))) continue;
+		for (int b = 0; b < Ingredient::sMaxEffects; b++)
+			if (   (this->knownMasks[row2] & (1 << b))
+				&& this->effectIds[a][row1] == this->effectIds[b][row2]
+				&& (!rarest || this->effectRarities[a][row1] > rarity))
+			{
+				rarest = this->effectIds[a][row1];
+				rarity = this->effectRarities[a][row1];
+			}
+	}
+	return rarest;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//                              Partner search
+//
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+// Gather the query's known effects, then hand the columns to the best kernel.
+void IngredientTable::scorePartners(const int queryRow, float* scores) const
+{
+	Query q;
+	q.count = 0;
+	for (int a = 0; a < Ingredient::sMaxEffects; a++)
+		if (this->knownMasks[queryRow] & (1 << a)) {
+			q.ids[q.count] = this->effectIds[a][queryRow];
+			q.rarities[q.count] = this->effectRarities[a][queryRow];
+			q.count++;
+		}
+
+	Columns c;
+	for (int b = 0; b < Ingredient::sMaxEffects; b++)
+		c.effectIds[b] = this->effectIds[b].data();
+	c.knownMasks = this->knownMasks.data();
+	c.stock = this->stock.data();
+	c.size = size();
+
+#ifdef POTIONS_X86_SIMD
+	if (hasAVX2())
+		scoreAVX2(q, c, scores);
+	else
+#ifdef __SSE2__
+		scoreSSE2(q, c, scores);
+#else
+		scoreScalar(q, c, 0, scores);
+#endif
+#else
+	scoreScalar(q, c, 0, scores);
+#endif
+
+	// An ingredient can't be combined with itself.
+	scores[queryRow] = 0.0f;
+}
+
+//------------------------------------------------------------------------------
+// Score every row, then take the first of the highest scores.
+IngredientTable::Partner IngredientTable::bestPartner
+	(const Ingredient& query) const
+{
+	Partner best(-1, 0.0f);
+	const int queryRow = rowOf(query);
+	if (queryRow < 0)
+		return best;
+
+	tScores.resize(size());
+	scorePartners(queryRow, tScores.data());
+
+	for (int j = 0; j < size(); j++)
+		if (tScores[j] > best.value)
+			best = Partner(j, tScores[j]);
+
+	return best;
+}
+
+//------------------------------------------------------------------------------
+// Score every row, then partially sort those with value.
+vector<IngredientTable::Partner> IngredientTable::topPartners
+	(const Ingredient& query, const int k) const
+{
+	vector<Partner> partners;
+	const int queryRow = rowOf(query);
+	if (queryRow < 0 || k <= 0)
+		return partners;
+
+	tScores.resize(size());
+	scorePartners(queryRow, tScores.data());
+
+	for (int j = 0; j < size(); j++)
+		if (tScores[j] > 0.0f)
+			partners.push_back(Partner(j, tScores[j]));
+
+	const int count = min<int>(k, partners.size());
+	partial_sort(partners.begin(), partners.begin() + count, partners.end(),
+				 morePromising);
+	partners.erase(partners.begin() + count, partners.end());
+
+	return partners;
+}
@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        IngredientTable.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (fixed width integers, thread_local)
+ *
+ * A structure-of-arrays mirror of an alchemist's ingredients. Each column is a
+ * contiguous array indexed by row, so a whole table of ingredients can be
+ * scanned with SIMD instructions rather than by walking Ingredient objects.
+ * The table holds each ingredient's effect ids and effect rarities (one column
+ * per effect slot), a bit mask of which slots the alchemist knows, and the
+ * current stock count.
+ *
+ * The partner search finds, for a query ingredient, the stocked ingredients
+ * sharing the most valuable status effect known in both. An AVX2 kernel is
+ * used when the processor supports it, then SSE2, then a scalar loop.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Ingredient.h"
+
+
+class IngredientTable
+{
+	// The ingredient each row mirrors.
+	std::vector<Ingredient> ingredients;
+
+	// Maps an ingredient id to its row, or -1 if it isn't in the table.
+	std::vector<int> rowsById;
+
+	// One column per effect slot, holding effect ids and their rarities.
+	std::vector<uint32_t> effectIds[Ingredient::sMaxEffects];
+	std::vector<float> effectRarities[Ingredient::sMaxEffects];
+
+	// Bit i is set if the effect in slot i is known.
+	std::vector<uint8_t> knownMasks;
+
+	// The stock count of each row.
+	std::vector<uint32_t> stock;
+
+public:
+
+	// A candidate partner and the value of the potion it would make.
+	struct Partner
+	{
+		int row;
+		float value;
+
+		Partner(const int r, const float v) : row(r), value(v) {}
+	};
+
+	// Initializes an empty table.
+	IngredientTable();
+
+	// Returns the number of rows in the table.
+	int size() const;
+
+	// Adds a row for the ingredient with no stock and no known effects.
+	// Returns the existing row if the ingredient was already added.
+	int addIngredient(const Ingredient& ingredient);
+
+	// Returns the ingredient's row, or -1 if it isn't in the table.
+	int rowOf(const Ingredient& ingredient) const;
+	int rowOfId(const unsigned int id) const;
+
+	// Returns the ingredient mirrored by the row.
+	const Ingredient& getIngredient(const int row) const;
+
+	// The bytes the table's columns hold on the heap.
+	std::size_t getBytesHeld() const;
+
+	// Stock accessors - the row must exist.
+	unsigned int getStock(const int row) const;
+	void setStock(const int row, const unsigned int count);
+
+	// Marks the effect as known for the row's ingredient. Does nothing if the
+	// ingredient doesn't have the effect.
+	void markEffectKnown(const int row, const StatusEffect& effect);
+
+	// Returns the known effect bit mask of the row.
+	uint8_t getKnownMask(const int row) const;
+
+	// Returns true if the effect is known for the row's ingredient.
+	bool isEffectKnown(const int row, const StatusEffect& effect) const;
+
+	// Returns the id of the rarest effect known in both rows, or 0 if the
+	// rows share no known effect.
+	uint32_t rarestSharedKnownEffect(const int row1, const int row2) const;
+
+//------------------------------------------------------------------------------
+//                               Partner search
+//------------------------------------------------------------------------------
+
+	// Writes, for every row, the rarity of the rarest effect known in both the
+	// query row and that row. Rows out of stock, and the query row, score 0.
+	// scores must have room for size() values.
+	void scorePartners(const int queryRow, float* scores) const;
+
+	// Returns the stocked partner with the most valuable known shared effect.
+	// The returned row is -1 if there is no such partner.
+	Partner bestPartner(const Ingredient& query) const;
+
+	// Returns up to k stocked partners, most valuable first.
+	std::vector<Partner> topPartners(const Ingredient& query, const int k) const;
+};
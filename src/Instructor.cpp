@@ -3,49 +3,145 @@
  * File:        Instructor.h
  * Author:      Jocelyn Clifford-Frith
  * Date:        10th September 2013
- * Standard:    C++11 (<random>, auto types and range-based loops)
+ * Standard:    C++11 (auto types, range-based loops and lambdas)
  ******************************************************************************/
  
 #include "Instructor.h"
 #include <vector>
 #include <iostream>
-#include <random>
-#include <ctime>
+#include <algorithm>
+#include <atomic>
+#include "IntersectionEngine.h"
+#include "WeightedRandomizedStack.h"
+#include "ValueWeightedPairSampler.h"
+#include "SharedIngredientStore.h"
+#include "Instrumentation.h"
+#include "Trace.h"
 
 using namespace std;
 
-void Instructor::randomlyCombineRemainingPairs(Alchemist & alchemist)
+//------------------------------------------------------------------------------
+// Combines' values are averaged with exponentially falling weights, over
+// roughly the last window of them, and not judged until that many have been
+// made.
+void Instructor::randomlyCombineRemainingPairs
+	(Alchemist & alchemist, RandomStream& random,
+	 const double minValuePerCombine)
 {
+	POTIONS_PHASE("randomlyCombineRemainingPairs");
+	
 	// Make a local copy of the known ingredients
 	vector<Ingredient> ingredients = alchemist.allKnownIngredients();
+	const uint32_t count = ingredients.size();
 	
-	// Setup random distribution
-	default_random_engine randGen(time(0));
-	uniform_int_distribution<int> randDist(0, ingredients.size() - 1);
+	const int window = 32;
+	const double decay = 1.0 - 1.0 / window;
+	double recentValue = 0.0, recentWeight = 0.0;
+	int combines = 0;
 	
 	// Combine pairs of ingredients at random until no distinct pairs remain.
 	while (alchemist.calculateVarietiesInStock() > 1)
 	{
-		// Choose two different ingredients that are in stock
+		// Choose two different ingredients that are in stock. A shared store
+		// can run dry meanwhile, so give up after a bounded number of draws
+		// and count the varieties again.
 		Ingredient ingr1, ingr2;
-		while (!alchemist.hasIngredient(ingr1))
-			ingr1 = ingredients[randDist(randGen)];
-		while (!alchemist.hasIngredient(ingr2) || ingr1 == ingr2)
-			ingr2 = ingredients[randDist(randGen)];
+		for (uint32_t tries = 0; tries < count && !alchemist.hasIngredient(ingr1);
+			 tries++)
+			ingr1 = ingredients[random.nextBelow(count)];
+		for (uint32_t tries = 0; tries < count
+			 && (!alchemist.hasIngredient(ingr2) || ingr1 == ingr2); tries++)
+			ingr2 = ingredients[random.nextBelow(count)];
+		POTIONS_COUNT(RandomPairsDrawn);
+		if (ingr1 == ingr2)
+			continue;
+		
+		// Combine them, if they're still in stock
+		Discovery discovery;
+		if (!alchemist.tryCombine(ingr1, ingr2, &discovery))
+			continue;
 		
-		// Combine them
-		alchemist.combine(ingr1, ingr2);
+		// Stop once neither chance nor known matches are paying their way.
+		recentValue = recentValue * decay + discovery.potionValue;
+		recentWeight = recentWeight * decay + 1.0;
+		if (   minValuePerCombine > 0.0 && ++combines >= window
+			&& recentValue < minValuePerCombine * recentWeight
+			&& alchemist.estimateRemainingValue() < minValuePerCombine)
+			break;
+	}
+}
+
+//------------------------------------------------------------------------------
+// The stack's weights follow the stock through each combine, in O(log n), so
+// it's never rebuilt. A stock that runs out - here or, with a shared store,
+// elsewhere - is removed. The first choice is weighted zero while the second
+// is drawn, so they differ.
+void Instructor::randomlyCombineStockWeightedPairs
+	(Alchemist& alchemist, RandomStream& random)
+{
+	POTIONS_PHASE("randomlyCombineStockWeightedPairs");
+	
+	typedef WeightedRandomizedStack<Ingredient>::Handle Handle;
+	WeightedRandomizedStack<Ingredient> stock;
+	for (const Ingredient& ingredient : alchemist.allKnownIngredients())
+		if (alchemist.hasIngredient(ingredient))
+			stock.push(ingredient, alchemist.countOfIngredient(ingredient));
+	
+	// Re-weights the ingredient by its current stock, removing it if none.
+	auto restock = [&](const Handle handle) {
+		const int count = alchemist.countOfIngredient(stock.get(handle));
+		if (count > 0)
+			stock.updateWeight(handle, count);
+		else
+			stock.remove(handle);
+	};
+	
+	while (stock.size() > 1)
+	{
+		const Handle handle1 = stock.sample(random);
+		const double weight1 = stock.getWeight(handle1);
+		stock.updateWeight(handle1, 0.0);
+		const Handle handle2 = stock.sample(random);
+		stock.updateWeight(handle1, weight1);
+		POTIONS_COUNT(RandomPairsDrawn);
+		
+		alchemist.tryCombine(stock.get(handle1), stock.get(handle2));
+		restock(handle1);
+		restock(handle2);
+	}
+}
+
+//------------------------------------------------------------------------------
+// The drawn rows are stocked, since only stocked rows have weight, so every
+// combine succeeds.
+void Instructor::randomlyCombineValueWeightedPairs
+	(Alchemist& alchemist, RandomStream& random)
+{
+	POTIONS_PHASE("randomlyCombineValueWeightedPairs");
+	
+	ValueWeightedPairSampler sampler(alchemist);
+	const IngredientTable& table = alchemist.getIngredientTable();
+	ValueWeightedPairSampler::Draw draw;
+	while (sampler.draw(alchemist, random, draw))
+	{
+		Discovery discovery;
+		alchemist.tryCombine(table.getIngredient(draw.row1),
+							 table.getIngredient(draw.row2), &discovery);
+		sampler.learn(alchemist, draw, discovery);
 	}
 }
 
 void Instructor::combineAllPairsWithMatchingEffects(Alchemist & alchemist)
 {
+	POTIONS_PHASE("combineAllPairsWithMatchingEffects");
+	
 	int passes = 0;
 	bool succeededLastPass = true;
 	while (succeededLastPass)
 	{
 	passes++;
 	succeededLastPass = false;
+	POTIONS_COUNT(MatchingPairsPasses);
 	
 		// Collect the known status effects
 		vector<StatusEffect> knownEffects = alchemist.allKnownEffects();
@@ -54,10 +150,12 @@ void Instructor::combineAllPairsWithMatchingEffects(Alchemist & alchemist)
 		for (const StatusEffect& effect : knownEffects) {
 			
 			// Copy vector, rather than reference, so iterators don't invalidate.
-			auto ingredients = alchemist.getIngredientsWithEffect(effect);
+			vector<Ingredient> ingredients;
+			for (const uint32_t id : alchemist.getIngredientsWithEffect(effect))
+				ingredients.push_back(Ingredient::fromId(id));
 			
 			// Skip onto next effect if only one ingredient is known
-			if (ingredients.size() < 2) break;
+			if (ingredients.size() < 2) continue;
 			
 			// Iterate across ingredients, combining those in stock.
 			auto i1 = ingredients.begin();
@@ -76,10 +174,340 @@ void Instructor::combineAllPairsWithMatchingEffects(Alchemist & alchemist)
 				if (i1 != ingredients.end() && i2 != ingredients.end())
 				{
 					// Make a potion
-					alchemist.combine(*i1, *i2);
-					succeededLastPass = true;
+					if (alchemist.tryCombine(*i1, *i2))
+						succeededLastPass = true;
 				}
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+
+//------------------------------------------------------------------------------
+// Called once per batch, so it has no phase of its own. Repeated ids in the
+// batch find their ingredient already used up, or without a partner.
+void Instructor::combineArrivals(Alchemist& alchemist,
+								 const vector<uint32_t>& arrivals)
+{
+	for (const uint32_t id : arrivals)
+	{
+		const Ingredient& ingredient = Ingredient::fromId(id);
+		while (alchemist.hasIngredient(ingredient))
+		{
+			const Ingredient partner = alchemist.findBestPartner(ingredient);
+			if (partner == Ingredient::nullValue
+				|| !alchemist.tryCombine(ingredient, partner))
+				break;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Helpers for combineBestTriples()
+namespace
+{
+	typedef IntersectionEngine::TripleCandidate TripleCandidate;
+	
+	// Collects an effect pair's triples, up to a limit.
+	struct TripleCollector
+	{
+		vector<TripleCandidate>& candidates;
+		size_t remaining;
+		
+		TripleCollector(vector<TripleCandidate>& c, const size_t limit) :
+			candidates(c), remaining(limit) {}
+		
+		bool operator()(const TripleCandidate& candidate)
+		{
+			candidates.push_back(candidate);
+			return --remaining > 0;
+		}
+	};
+	
+	// Raises the shared pruning threshold to at least the value.
+	void raiseThreshold(atomic<double>& threshold, const double value)
+	{
+		double current = threshold.load();
+		while (current < value
+			   && !threshold.compare_exchange_weak(current, value));
+	}
+	
+	// Searches the triples pairing effects[anchor] with each less rare effect.
+	// Effects are sorted rarest first, so values only fall as the search goes
+	// on, and it stops once they fall below the threshold.
+	void searchAnchor(const Alchemist& alchemist,
+					  const vector<StatusEffect>& effects, const size_t anchor,
+					  const size_t limit, atomic<double>& threshold,
+					  vector<TripleCandidate>& found)
+	{
+		const double anchorRarity = effects[anchor].getRarity();
+		for (size_t b = anchor + 1; b < effects.size(); b++)
+		{
+			if (anchorRarity + effects[b].getRarity() < threshold)
+				break;
+			
+			TripleCollector collect(found, limit);
+			IntersectionEngine::forEachTriple
+				(alchemist, effects[anchor], effects[b], collect);
+			
+			// With limit candidates at least this valuable found here, the
+			// limit best overall are at least this valuable too.
+			if (found.size() >= limit)
+				raiseThreshold(threshold, found[limit - 1].value);
+		}
+	}
+	
+	bool rarer(const StatusEffect& lhs, const StatusEffect& rhs)
+	{
+		return lhs.getRarity() > rhs.getRarity();
+	}
+	
+	bool moreValuable(const TripleCandidate& lhs, const TripleCandidate& rhs)
+	{
+		return lhs.value > rhs.value;
+	}
+	
+	bool lessPromising(const Ingredient& lhs, const Ingredient& rhs)
+	{
+		return lhs.getBestPotionValue() < rhs.getBestPotionValue();
+	}
+	
+	// Returns the least promising stocked ingredient other than the two given,
+	// or Ingredient::nullValue. Fillers run out in order, so first is moved
+	// past those that have.
+	Ingredient chooseFiller(const Alchemist& alchemist,
+							const vector<Ingredient>& fillers, size_t& first,
+							const Ingredient& ingredient1,
+							const Ingredient& ingredient2)
+	{
+		while (first < fillers.size() && !alchemist.hasIngredient(fillers[first]))
+			first++;
+		
+		for (size_t i = first; i < fillers.size(); i++)
+			if (   !(fillers[i] == ingredient1) && !(fillers[i] == ingredient2)
+				&& alchemist.hasIngredient(fillers[i]))
+				return fillers[i];
+		
+		return Ingredient::nullValue;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Each round searches the known effects in parallel, then brews the candidates
+// in value order, skipping any whose stock has already been used.
+void Instructor::combineBestTriples(Alchemist& alchemist, ThreadPool& pool)
+{
+	POTIONS_PHASE("combineBestTriples");
+	
+	bool succeededLastRound = true;
+	while (succeededLastRound)
+	{
+		succeededLastRound = false;
+		POTIONS_COUNT(BestTriplesRounds);
+		
+		vector<StatusEffect> effects = alchemist.allKnownEffects();
+		stable_sort(effects.begin(), effects.end(), rarer);
+		
+		// No more potions can be brewed than a third of the stock.
+		const size_t limit = alchemist.getTotalIngredientsRemaining() / 3;
+		if (limit == 0 || effects.size() < 2)
+			return;
+		
+		// Search each anchor effect as a separate task.
+		atomic<double> threshold(0.0);
+		vector<vector<TripleCandidate> > found(effects.size());
+		for (size_t anchor = 0; anchor + 1 < effects.size(); anchor++)
+			pool.submit([&, anchor]() {
+				POTIONS_PHASE("search anchor effect");
+				searchAnchor(alchemist, effects, anchor, limit, threshold,
+							 found[anchor]);
+			});
+		pool.wait();
+		
+		// Keep the candidates that survived pruning, most valuable first. Those
+		// below the final threshold depend on timing, so are left for the next
+		// round to find again.
+		vector<TripleCandidate> candidates;
+		for (auto& anchorCandidates : found)
+			for (auto& candidate : anchorCandidates)
+				if (candidate.value >= threshold)
+					candidates.push_back(candidate);
+		stable_sort(candidates.begin(), candidates.end(), moreValuable);
+		
+		// Fillers complete pairs sharing both effects, least promising first.
+		vector<Ingredient> fillers;
+		for (const Ingredient& ingredient : alchemist.allKnownIngredients())
+			if (alchemist.hasIngredient(ingredient))
+				fillers.push_back(ingredient);
+		stable_sort(fillers.begin(), fillers.end(), lessPromising);
+		size_t firstFiller = 0;
+		
+		// Brew while stock lasts.
+		for (const TripleCandidate& candidate : candidates)
+		{
+			const Ingredient& ingr1 = Ingredient::fromId(candidate.ingredients[0]);
+			const Ingredient& ingr2 = Ingredient::fromId(candidate.ingredients[1]);
+			if (!alchemist.hasIngredient(ingr1) || !alchemist.hasIngredient(ingr2))
+				continue;
+			
+			const Ingredient ingr3 = candidate.ingredients[2]
+				? Ingredient::fromId(candidate.ingredients[2])
+				: chooseFiller(alchemist, fillers, firstFiller, ingr1, ingr2);
+			if (!alchemist.hasIngredient(ingr3))
+				continue;
+			
+			if (alchemist.tryCombine(ingr1, ingr2, ingr3))
+				succeededLastRound = true;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Helpers for combineSpeculatively()
+namespace
+{
+	typedef IngredientTable::Partner Partner;
+	
+	// A stocked row and its best partner.
+	struct PairCandidate
+	{
+		int row;
+		Partner partner;
+	};
+	
+	bool moreValuablePair(const PairCandidate& lhs, const PairCandidate& rhs)
+	{
+		return lhs.partner.value > rhs.partner.value;
+	}
+	
+	// Brews the candidates one at a time, most valuable first, while stock
+	// lasts and neither ingredient has learned anything. Returns false if
+	// nothing could be brewed.
+	bool brewCandidatesInTurn(Alchemist& alchemist,
+							  const vector<PairCandidate>& candidates,
+							  vector<bool>& changed)
+	{
+		const IngredientTable& table = alchemist.getIngredientTable();
+		bool brewed = false;
+		for (const PairCandidate& candidate : candidates)
+		{
+			const int row1 = candidate.row, row2 = candidate.partner.row;
+			const Ingredient& ingr1 = table.getIngredient(row1);
+			const Ingredient& ingr2 = table.getIngredient(row2);
+			Discovery discovery;
+			while (   !changed[row1] && !changed[row2]
+				   && alchemist.tryCombine(ingr1, ingr2, &discovery))
+			{
+				brewed = true;
+				for (int i = 0; i < discovery.findingsCount(); i++)
+					changed[table.rowOf(discovery.getIngredient(i))] = true;
+			}
+		}
+		return brewed;
+	}
+}
+
+//------------------------------------------------------------------------------
+// A pair's score depends only on its own rows' known effects, which change
+// only when a combine learns something about them - so a candidate neither of
+// whose ingredients has learned anything this round is still worth exactly its
+// score. Candidates are brewed in batches of pairs with no ingredient in
+// common, so no combine in a batch changes another's score; those still worth
+// their score join the next batch, while stock lasts. Rows are scored in
+// chunks, a few per thread, and each writes only its own slots.
+//
+// A shared store can't be brewed in batches, and the table's stock doesn't
+// follow it, so each round scores a copy of the table holding the store's
+// counts, and brews the candidates in turn. Other alchemists may take a
+// candidate's stock meanwhile, so a round brewing nothing ends the search only
+// if the store hasn't changed since it was scored.
+void Instructor::combineSpeculatively(Alchemist& alchemist, ThreadPool& pool)
+{
+	POTIONS_PHASE("combineSpeculatively");
+	
+	const IngredientTable& table = alchemist.getIngredientTable();
+	const SharedIngredientStore* const store = alchemist.getSharedStore();
+	IngredientTable storeTable;
+	const IngredientTable& scored = store ? storeTable : table;
+	const int chunks = 4 * pool.size();
+	vector<Partner> partners;
+	vector<PairCandidate> candidates;
+	vector<bool> changed, taken;
+	vector<BatchCombine> batch;
+	BatchResults results;
+	
+	for (;;)
+	{
+		POTIONS_COUNT(SpeculativeRounds);
+		const int rows = table.size();
+		const int remaining = alchemist.getTotalIngredientsRemaining();
+		if (store)
+		{
+			storeTable = table;
+			for (int row = 0; row < rows; row++)
+				storeTable.setStock(row,
+					store->countOfId(table.getIngredient(row).getId()));
+		}
+		
+		partners.assign(rows, Partner(-1, 0.0f));
+		for (int chunk = 0; chunk < chunks; chunk++)
+			pool.submit([&, chunk]() {
+				POTIONS_PHASE("score candidates");
+				for (int row = chunk * rows / chunks;
+					 row < (chunk + 1) * rows / chunks; row++)
+					if (scored.getStock(row) > 0)
+						partners[row] =
+							scored.bestPartner(scored.getIngredient(row));
+			});
+		pool.wait();
+		
+		// Most valuable first, ties in row order, so the threads can't change
+		// which are brewed.
+		candidates.clear();
+		for (int row = 0; row < rows; row++)
+			if (partners[row].row >= 0) {
+				const PairCandidate candidate = {row, partners[row]};
+				candidates.push_back(candidate);
+			}
+		if (candidates.empty())
+			return;
+		stable_sort(candidates.begin(), candidates.end(), moreValuablePair);
+		
+		changed.assign(rows, false);
+		if (store)
+		{
+			if (   !brewCandidatesInTurn(alchemist, candidates, changed)
+				&& alchemist.getTotalIngredientsRemaining() == remaining)
+				return;
+		}
+		else for (;;)
+		{
+			// The first batch holds the most valuable candidate, so every
+			// round brews something.
+			batch.clear();
+			taken.assign(rows, false);
+			for (const PairCandidate& candidate : candidates)
+			{
+				const int row1 = candidate.row, row2 = candidate.partner.row;
+				if (   changed[row1] || changed[row2] || taken[row1]
+					|| taken[row2] || table.getStock(row1) == 0
+					|| table.getStock(row2) == 0)
+					continue;
+				taken[row1] = taken[row2] = true;
+				const BatchCombine combine =
+					{{table.getIngredient(row1).getId(),
+					  table.getIngredient(row2).getId(), 0}};
+				batch.push_back(combine);
+			}
+			if (batch.empty())
+				break;
+			
+			alchemist.combineBatch(batch.data(), batch.size(), results);
+			for (const BatchResults::Finding& finding : results.allFindings())
+				changed[table.rowOfId(finding.ingredientId)] = true;
+		}
+		
+		for (const PairCandidate& candidate : candidates)
+			if (changed[candidate.row] || changed[candidate.partner.row])
+				POTIONS_COUNT(SpeculativeConflicts);
+	}
+}
@@ -12,15 +12,53 @@
  
 #pragma once
 #include "Alchemist.h"
+#include "ThreadPool.h"
 
 class Instructor
 {
 public:
-	// Simply combines ingredients at random until it runs out of stock.
-	static void randomlyCombineRemainingPairs(Alchemist& alchemist);
+	// Simply combines ingredients at random until it runs out of stock. Given
+	// a minimum value per combine, it stops early once the recent combines'
+	// average value, and the alchemist's estimate of what known matches could
+	// still brew, have both fallen below it.
+	static void randomlyCombineRemainingPairs
+		(Alchemist& alchemist, RandomStream& random = RandomStream::local(),
+		 const double minValuePerCombine = 0.0);
+	
+	// As above, but draws each ingredient in proportion to its stock, as if
+	// picked blindly from the store, rather than each variety alike.
+	static void randomlyCombineStockWeightedPairs
+		(Alchemist& alchemist, RandomStream& random = RandomStream::local());
+	
+	// As above, but draws each pair in proportion to its expected value - from
+	// its known shared effects, and the hidden value of its unknown ones - as
+	// a ValueWeightedPairSampler, learning from each discovery. Stops once no
+	// pair is expected to be worth anything: when the stock's effects are all
+	// known and none are shared. Throws logic_error if the store is shared.
+	static void randomlyCombineValueWeightedPairs
+		(Alchemist& alchemist, RandomStream& random = RandomStream::local());
 	
 	// Combines ingredient pairs known to have a common effect. Upon
 	// discovering a new effect, it will check for new combinations. The
 	// remaining ingredients are combined at random like ApproachA
 	static void combineAllPairsWithMatchingEffects(Alchemist& alchemist);
+	
+	// Reacts to newly stocked ingredients, as a streaming strategy: brews each
+	// arrival with its best known partner while both are in stock.
+	static void combineArrivals(Alchemist& alchemist,
+								const std::vector<uint32_t>& arrivals);
+	
+	// Brews three ingredient potions known to have two effects, most valuable
+	// first, while stock lasts. The search is split by anchor effect across the
+	// pool's threads, and repeated while new combinations are found.
+	static void combineBestTriples(Alchemist& alchemist, ThreadPool& pool);
+	
+	// Brews known matching pairs in rounds. Each round scores every stocked
+	// ingredient's best partner in parallel, against the knowledge as it
+	// stood at the round's start, then brews the candidates in batches, most
+	// valuable first, while stock lasts - skipping any with an ingredient that
+	// has learned an effect since, whose score may be stale, to be scored
+	// again next round. With a shared store the candidates are scored against
+	// the store's counts and brewed one at a time instead.
+	static void combineSpeculatively(Alchemist& alchemist, ThreadPool& pool);
 };
\ No newline at end of file
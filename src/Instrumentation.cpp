@@ -0,0 +1,210 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        Instrumentation.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<atomic>, thread_local)
+ ******************************************************************************/
+
+#include "Instrumentation.h"
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include "Discovery.h"
+
+using namespace std;
+
+namespace
+{
+	// A set of counts. Each is written by one thread, but may be read by any,
+	// so they're atomics used with relaxed ordering - plain loads and stores.
+	struct Counts
+	{
+		atomic<uint64_t> counters[Instrumentation::sCounterCount];
+		atomic<uint64_t> buckets[Instrumentation::sHistogramCount]
+								[Instrumentation::sBucketCount];
+
+		Counts()
+		{
+			clear();
+		}
+
+		void clear()
+		{
+			for (auto& counter : counters)
+				counter.store(0, memory_order_relaxed);
+			for (auto& histogram : buckets)
+				for (auto& bucket : histogram)
+					bucket.store(0, memory_order_relaxed);
+		}
+	};
+
+	// The counts of live threads, and the sum of those that have exited.
+	struct Registry
+	{
+		mutex blocksMutex;
+		vector<const Counts*> live;
+		Counts retired;
+	};
+
+	Registry& registry()
+	{
+		static Registry sRegistry;
+		return sRegistry;
+	}
+
+	// A thread's counts, registered while the thread lives.
+	struct ThreadCounts : Counts
+	{
+		ThreadCounts()
+		{
+			Registry& r = registry();
+			lock_guard<mutex> lock(r.blocksMutex);
+			r.live.push_back(this);
+		}
+
+		~ThreadCounts()
+		{
+			Registry& r = registry();
+			lock_guard<mutex> lock(r.blocksMutex);
+			r.live.erase(find(r.live.begin(), r.live.end(), this));
+			for (int c = 0; c < Instrumentation::sCounterCount; c++)
+				r.retired.counters[c] += counters[c].load(memory_order_relaxed);
+			for (int h = 0; h < Instrumentation::sHistogramCount; h++)
+				for (int b = 0; b < Instrumentation::sBucketCount; b++)
+					r.retired.buckets[h][b] +=
+						buckets[h][b].load(memory_order_relaxed);
+		}
+	};
+
+	thread_local ThreadCounts tCounts;
+
+	// Only the owning thread writes, so a load and store is enough.
+	void add(atomic<uint64_t>& count, const uint64_t n)
+	{
+		count.store(count.load(memory_order_relaxed) + n, memory_order_relaxed);
+	}
+
+	// The number of buckets each histogram uses.
+	int bucketsUsed(const Instrumentation::Histogram histogram)
+	{
+		if (histogram == Instrumentation::DiscoveriesPerCombine)
+			return Discovery::sMaxFindings + 1;
+		return Instrumentation::sBucketCount;
+	}
+
+	int bucketOf(const Instrumentation::Histogram histogram, const double value)
+	{
+		int bucket = 0;
+		if (histogram == Instrumentation::PotionValue) {
+			if (value >= 1.0)
+				frexp(value, &bucket);
+		}
+		else
+			bucket = static_cast<int>(value);
+
+		return max(0, min(bucket, bucketsUsed(histogram) - 1));
+	}
+}
+
+//------------------------------------------------------------------------------
+void Instrumentation::count(const Counter counter, const uint64_t n)
+{
+	add(tCounts.counters[counter], n);
+}
+
+//------------------------------------------------------------------------------
+void Instrumentation::record(const Histogram histogram, const double value)
+{
+	add(tCounts.buckets[histogram][bucketOf(histogram, value)], 1);
+}
+
+//------------------------------------------------------------------------------
+uint64_t Instrumentation::total(const Counter counter)
+{
+	Registry& r = registry();
+	lock_guard<mutex> lock(r.blocksMutex);
+	uint64_t sum = r.retired.counters[counter].load(memory_order_relaxed);
+	for (const Counts* counts : r.live)
+		sum += counts->counters[counter].load(memory_order_relaxed);
+	return sum;
+}
+
+//------------------------------------------------------------------------------
+uint64_t Instrumentation::bucketTotal(const Histogram histogram,
+									  const int bucket)
+{
+	Registry& r = registry();
+	lock_guard<mutex> lock(r.blocksMutex);
+	uint64_t sum = r.retired.buckets[histogram][bucket]
+		.load(memory_order_relaxed);
+	for (const Counts* counts : r.live)
+		sum += counts->buckets[histogram][bucket].load(memory_order_relaxed);
+	return sum;
+}
+
+//------------------------------------------------------------------------------
+void Instrumentation::reset()
+{
+	Registry& r = registry();
+	lock_guard<mutex> lock(r.blocksMutex);
+	r.retired.clear();
+	for (const Counts* counts : r.live)
+		const_cast<Counts*>(counts)->clear();
+}
+
+//------------------------------------------------------------------------------
+// Counters are written as name-value pairs, histograms as arrays of buckets.
+void Instrumentation::writeJson(ostream& out)
+{
+	out << "{" << endl
+		<< "\t\"enabled\": " << (isEnabled() ? "true" : "false") << "," << endl
+		<< "\t\"counters\": {" << endl;
+	for (int c = 0; c < sCounterCount; c++)
+		out << "\t\t\"" << counterName(Counter(c)) << "\": "
+			<< total(Counter(c)) << (c + 1 < sCounterCount ? "," : "") << endl;
+	out << "\t}," << endl
+		<< "\t\"histograms\": {" << endl;
+	for (int h = 0; h < sHistogramCount; h++)
+	{
+		out << "\t\t\"" << histogramName(Histogram(h)) << "\": [";
+		for (int b = 0; b < bucketsUsed(Histogram(h)); b++)
+			out << (b ? ", " : "") << bucketTotal(Histogram(h), b);
+		out << "]" << (h + 1 < sHistogramCount ? "," : "") << endl;
+	}
+	out << "\t}" << endl
+		<< "}" << endl;
+}
+
+//------------------------------------------------------------------------------
+bool Instrumentation::isEnabled()
+{
+#ifdef POTIONS_INSTRUMENT
+	return true;
+#else
+	return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+const char* Instrumentation::counterName(const Counter counter)
+{
+	static const char* const sNames[sCounterCount] = {
+		"combines", "ingredientsDiscovered", "storeLookups", "tableLookups",
+		"effectsLearned", "randomPairsDrawn", "matchingPairsPasses",
+		"bestTriplesRounds", "speculativeRounds", "speculativeConflicts",
+		"schedulerSlices"
+	};
+	return sNames[counter];
+}
+
+//------------------------------------------------------------------------------
+const char* Instrumentation::histogramName(const Histogram histogram)
+{
+	static const char* const sNames[sHistogramCount] = {
+		"potionValue", "discoveriesPerCombine"
+	};
+	return sNames[histogram];
+}
@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        Instrumentation.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<atomic>, thread_local)
+ *
+ * Counters and histograms for the simulation's hot paths, exported as JSON at
+ * the end of a run.
+ *
+ * Recording is done through the POTIONS_COUNT and POTIONS_RECORD macros,
+ * which only do anything when POTIONS_INSTRUMENT is defined (make
+ * INSTRUMENT=1). Otherwise they expand to nothing, so cost nothing.
+ *
+ * Each thread records into its own block of counts, written only by that
+ * thread, so recording never contends. Blocks are summed when read, and a
+ * thread's counts are kept when it exits.
+ ******************************************************************************/
+
+#pragma once
+#include <ostream>
+#include <cstdint>
+
+#ifdef POTIONS_INSTRUMENT
+	#define POTIONS_COUNT(counter) \
+		Instrumentation::count(Instrumentation::counter)
+	#define POTIONS_COUNT_N(counter, n) \
+		Instrumentation::count(Instrumentation::counter, n)
+	#define POTIONS_RECORD(histogram, value) \
+		Instrumentation::record(Instrumentation::histogram, value)
+#else
+	#define POTIONS_COUNT(counter) ((void)0)
+	#define POTIONS_COUNT_N(counter, n) ((void)0)
+	#define POTIONS_RECORD(histogram, value) ((void)0)
+#endif
+
+
+class Instrumentation
+{
+public:
+	enum Counter
+	{
+		Combines,
+		IngredientsDiscovered,
+		StoreLookups,
+		TableLookups,
+		EffectsLearned,
+		RandomPairsDrawn,
+		MatchingPairsPasses,
+		BestTriplesRounds,
+		SpeculativeRounds,
+		SpeculativeConflicts,
+		SchedulerSlices,
+		sCounterCount
+	};
+
+	enum Histogram
+	{
+		// Bucket 0 holds values below 1, bucket k values in [2^(k-1), 2^k).
+		PotionValue,
+
+		// One bucket per count, up to Discovery::sMaxFindings.
+		DiscoveriesPerCombine,
+		sHistogramCount
+	};
+
+	static const int sBucketCount = 32;
+
+	// Adds to a counter on the calling thread.
+	static void count(const Counter counter, const uint64_t n = 1);
+
+	// Adds one to the histogram's bucket for the value.
+	static void record(const Histogram histogram, const double value);
+
+	// The totals across all threads.
+	static uint64_t total(const Counter counter);
+	static uint64_t bucketTotal(const Histogram histogram, const int bucket);
+
+	// Zeros every count, on every thread. Counts recorded meanwhile may be
+	// lost.
+	static void reset();
+
+	// Writes the totals as a JSON object.
+	static void writeJson(std::ostream& out);
+
+	// True if built with POTIONS_INSTRUMENT.
+	static bool isEnabled();
+
+	static const char* counterName(const Counter counter);
+	static const char* histogramName(const Histogram histogram);
+};
@@ -0,0 +1,169 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        IntersectionEngine.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (fixed width integers)
+ ******************************************************************************/
+
+#include "IntersectionEngine.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+	// Galloping pays off once one list is this many times longer.
+	const int sGallopRatio = 32;
+
+	//--------------------------------------------------------------------------
+	// Merge the lists from the given positions onwards.
+	void mergeScalar(const uint32_t* a, const int aSize, int i,
+					 const uint32_t* b, const int bSize, int j,
+					 vector<uint32_t>& out)
+	{
+		while (i < aSize && j < bSize)
+		{
+			if (a[i] < b[j]) i++;
+			else if (b[j] < a[i]) j++;
+			else { out.push_back(a[i]); i++; j++; }
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// For each id of the short list, gallop ahead in the long list to bracket
+	// it, then binary search the bracket.
+	void gallop(const uint32_t* small, const int smallSize,
+				const uint32_t* large, const int largeSize,
+				vector<uint32_t>& out)
+	{
+		int low = 0;
+		for (int i = 0; i < smallSize && low < largeSize; i++)
+		{
+			const uint32_t id = small[i];
+			int step = 1;
+			int high = low;
+			while (high < largeSize && large[high] < id) {
+				low = high + 1;
+				high += step;
+				step *= 2;
+			}
+			const uint32_t* found =
+				lower_bound(large + low, large + min(high + 1, largeSize), id);
+			low = found - large;
+			if (low < largeSize && *found == id)
+				out.push_back(id);
+		}
+	}
+
+#ifdef __SSE2__
+	//--------------------------------------------------------------------------
+	// Compare blocks of four ids against every rotation of each other, then
+	// advance whichever block ends lower. Ids are unique within a list, so
+	// each match is found exactly once.
+	void mergeSSE2(const uint32_t* a, const int aSize,
+				   const uint32_t* b, const int bSize,
+				   vector<uint32_t>& out)
+	{
+		int i = 0, j = 0;
+		while (i + 4 <= aSize && j + 4 <= bSize)
+		{
+			const __m128i va =
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+			const __m128i vb =
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+
+			__m128i matches = _mm_cmpeq_epi32(va, vb);
+			matches = _mm_or_si128(matches, _mm_cmpeq_epi32(va,
+				_mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+			matches = _mm_or_si128(matches, _mm_cmpeq_epi32(va,
+				_mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+			matches = _mm_or_si128(matches, _mm_cmpeq_epi32(va,
+				_mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+
+			const int mask = _mm_movemask_ps(_mm_castsi128_ps(matches));
+			for (int k = 0; k < 4; k++)
+				if (mask & (1 << k))
+					out.push_back(a[i + k]);
+
+			const uint32_t aLast = a[i + 3];
+			const uint32_t bLast = b[j + 3];
+			if (aLast <= bLast) i += 4;
+			if (bLast <= aLast) j += 4;
+		}
+		mergeScalar(a, aSize, i, b, bSize, j, out);
+	}
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Pick a method by the lists' relative sizes.
+void IntersectionEngine::intersect(const uint32_t* a, const int aSize,
+								   const uint32_t* b, const int bSize,
+								   vector<uint32_t>& out)
+{
+	out.clear();
+	if (aSize == 0 || bSize == 0)
+		return;
+
+	if (aSize * sGallopRatio < bSize)
+		gallop(a, aSize, b, bSize, out);
+	else if (bSize * sGallopRatio < aSize)
+		gallop(b, bSize, a, aSize, out);
+	else
+#ifdef __SSE2__
+		mergeSSE2(a, aSize, b, bSize, out);
+#else
+		mergeScalar(a, aSize, 0, b, bSize, 0, out);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Filter the effect's posting list by the alchemist's stock.
+void IntersectionEngine::stockedWithEffect(const Alchemist& alchemist,
+										   const StatusEffect& effect,
+										   vector<uint32_t>& out)
+{
+	out.clear();
+	for (const uint32_t id : alchemist.getIngredientsWithEffect(effect))
+		if (alchemist.stockOfId(id) > 0)
+			out.push_back(id);
+}
+
+//------------------------------------------------------------------------------
+// Visitors collecting candidates into a vector.
+namespace
+{
+	template<class Candidate> struct Collector
+	{
+		vector<Candidate>& candidates;
+
+		explicit Collector(vector<Candidate>& c) : candidates(c) {}
+		bool operator()(const Candidate& c)
+		{
+			candidates.push_back(c);
+			return true;
+		}
+	};
+}
+
+vector<IntersectionEngine::PairCandidate> IntersectionEngine::findPairs
+	(const Alchemist& alchemist)
+{
+	vector<PairCandidate> pairs;
+	Collector<PairCandidate> collect(pairs);
+	forEachPair(alchemist, collect);
+	return pairs;
+}
+
+vector<IntersectionEngine::TripleCandidate> IntersectionEngine::findTriples
+	(const Alchemist& alchemist)
+{
+	vector<TripleCandidate> triples;
+	Collector<TripleCandidate> collect(triples);
+	forEachTriple(alchemist, collect);
+	return triples;
+}
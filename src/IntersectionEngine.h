@@ -0,0 +1,179 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        IntersectionEngine.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (fixed width integers)
+ *
+ * Enumerates the combinations an alchemist already knows will make a potion,
+ * using the sorted posting lists of its effectsReference rather than trying
+ * every pair or triple of ingredients.
+ *
+ * Pairs share one known effect, and are each reported once, under their
+ * rarest shared effect. Triples share two known effects, A and B, each known
+ * in at least two of the three ingredients - so one ingredient (an anchor)
+ * must have both. Anchors are found by intersecting the lists of A and B.
+ * A lone anchor is paired with one ingredient having only A and one having
+ * only B. Two anchors make the potion with any third ingredient, so such
+ * triples are reported once, with a third id of 0, and the caller chooses the
+ * filler. Each set is reported once per pair of effects.
+ *
+ * Only ingredients in stock are considered.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "Alchemist.h"
+
+
+class IntersectionEngine
+{
+public:
+	// Two ingredients known to share an effect.
+	struct PairCandidate
+	{
+		uint32_t ingredients[2];
+		uint32_t effect;
+		double value;
+	};
+
+	// Three ingredients known to share two effects.
+	struct TripleCandidate
+	{
+		uint32_t ingredients[3];
+		uint32_t effects[2];
+		double value;
+	};
+
+	// Writes the ids in both sorted lists to out, in ascending order. Galloping
+	// search is used when one list is much shorter than the other, otherwise a
+	// SIMD merge.
+	static void intersect(const uint32_t* a, const int aSize,
+						  const uint32_t* b, const int bSize,
+						  std::vector<uint32_t>& out);
+
+	// Writes the ids of the in-stock ingredients known to have the effect.
+	static void stockedWithEffect(const Alchemist& alchemist,
+								  const StatusEffect& effect,
+								  std::vector<uint32_t>& out);
+
+	// Calls visit(const PairCandidate&) for every in-stock pair known to share
+	// an effect. Enumeration stops early if visit returns false, in which case
+	// false is returned.
+	template<class Visitor>
+	static bool forEachPair(const Alchemist& alchemist, Visitor& visit);
+
+	// Calls visit(const TripleCandidate&) for every in-stock triple known to
+	// share effects a and b. Stops early as above.
+	template<class Visitor>
+	static bool forEachTriple(const Alchemist& alchemist,
+							  const StatusEffect& a, const StatusEffect& b,
+							  Visitor& visit);
+
+	// As above, for every pair of known effects.
+	template<class Visitor>
+	static bool forEachTriple(const Alchemist& alchemist, Visitor& visit);
+
+	// Collect every candidate into a vector.
+	static std::vector<PairCandidate> findPairs(const Alchemist& alchemist);
+	static std::vector<TripleCandidate> findTriples(const Alchemist& alchemist);
+};
+
+//------------------------------------------------------------------------------
+// Pairs within each effect's list, skipping those whose rarest shared effect
+// is a different one.
+template<class Visitor>
+bool IntersectionEngine::forEachPair(const Alchemist& alchemist, Visitor& visit)
+{
+	const IngredientTable& table = alchemist.getIngredientTable();
+	std::vector<uint32_t> stocked;
+	std::vector<int> rows;
+
+	for (const StatusEffect& effect : alchemist.allKnownEffects())
+	{
+		stockedWithEffect(alchemist, effect, stocked);
+		rows.clear();
+		for (const uint32_t id : stocked)
+			rows.push_back(table.rowOfId(id));
+
+		PairCandidate candidate;
+		candidate.effect = effect.getId();
+		candidate.value = effect.getRarity();
+
+		for (std::size_t i = 0; i < stocked.size(); i++)
+			for (std::size_t j = i + 1; j < stocked.size(); j++)
+				if (table.rarestSharedKnownEffect(rows[i], rows[j])
+					== candidate.effect)
+				{
+					candidate.ingredients[0] = stocked[i];
+					candidate.ingredients[1] = stocked[j];
+					if (!visit(candidate))
+						return false;
+				}
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Anchors come from the intersection of both lists. Pairs of anchors need only
+// a filler; a lone anchor takes one ingredient with just a and one with just b.
+template<class Visitor>
+bool IntersectionEngine::forEachTriple(const Alchemist& alchemist,
+									   const StatusEffect& a,
+									   const StatusEffect& b, Visitor& visit)
+{
+	std::vector<uint32_t> withA, withB, withBoth;
+	stockedWithEffect(alchemist, a, withA);
+	stockedWithEffect(alchemist, b, withB);
+	intersect(withA.data(), withA.size(), withB.data(), withB.size(), withBoth);
+
+	TripleCandidate candidate;
+	candidate.effects[0] = a.getId();
+	candidate.effects[1] = b.getId();
+	candidate.value = a.getRarity() + b.getRarity();
+
+	for (std::size_t i = 0; i < withBoth.size(); i++)
+	{
+		const uint32_t x = withBoth[i];
+		candidate.ingredients[0] = x;
+
+		for (std::size_t j = i + 1; j < withBoth.size(); j++) {
+			candidate.ingredients[1] = withBoth[j];
+			candidate.ingredients[2] = 0;
+			if (!visit(candidate))
+				return false;
+		}
+
+		for (const uint32_t y : withA)
+		{
+			if (std::binary_search(withBoth.begin(), withBoth.end(), y))
+				continue;
+			candidate.ingredients[1] = y;
+
+			for (const uint32_t z : withB)
+			{
+				if (std::binary_search(withBoth.begin(), withBoth.end(), z))
+					continue;
+				candidate.ingredients[2] = z;
+				if (!visit(candidate))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+template<class Visitor>
+bool IntersectionEngine::forEachTriple(const Alchemist& alchemist,
+									   Visitor& visit)
+{
+	const std::vector<StatusEffect> effects = alchemist.allKnownEffects();
+	for (std::size_t i = 0; i < effects.size(); i++)
+		for (std::size_t j = i + 1; j < effects.size(); j++)
+			if (!forEachTriple(alchemist, effects[i], effects[j], visit))
+				return false;
+	return true;
+}
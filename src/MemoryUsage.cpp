@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        MemoryUsage.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<mutex>)
+ ******************************************************************************/
+
+#include "MemoryUsage.h"
+#include <algorithm>
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+mutex MemoryUsage::sLargestMutex;
+map<string, size_t> MemoryUsage::sLargest;
+
+//------------------------------------------------------------------------------
+void MemoryUsage::add(const string& name, const size_t bytes)
+{
+	for (Part& part : this->parts)
+		if (part.name == name) {
+			part.bytes += bytes;
+			return;
+		}
+	Part part = {name, bytes};
+	this->parts.push_back(part);
+}
+
+//------------------------------------------------------------------------------
+void MemoryUsage::add(const string& owner, const MemoryUsage& usage)
+{
+	for (const Part& part : usage.parts)
+		add(owner + "." + part.name, part.bytes);
+}
+
+//------------------------------------------------------------------------------
+const vector<MemoryUsage::Part>& MemoryUsage::getParts() const
+{
+	return this->parts;
+}
+
+//------------------------------------------------------------------------------
+size_t MemoryUsage::total() const
+{
+	size_t bytes = 0;
+	for (const Part& part : this->parts)
+		bytes += part.bytes;
+	return bytes;
+}
+
+//------------------------------------------------------------------------------
+void MemoryUsage::record(const string& owner) const
+{
+	lock_guard<mutex> lock(sLargestMutex);
+	for (const Part& part : this->parts) {
+		size_t& largest = sLargest[owner + "." + part.name];
+		largest = max(largest, part.bytes);
+	}
+	size_t& largest = sLargest[owner];
+	largest = max(largest, total());
+}
+
+//------------------------------------------------------------------------------
+size_t MemoryUsage::largestReported(const string& name)
+{
+	lock_guard<mutex> lock(sLargestMutex);
+	auto iLargest = sLargest.find(name);
+	return iLargest == sLargest.end() ? 0 : iLargest->second;
+}
+
+//------------------------------------------------------------------------------
+// Linux reports the peak in kilobytes, and macOS in bytes. Other systems
+// aren't asked.
+size_t MemoryUsage::peakResidentBytes()
+{
+#if defined(__linux__) || defined(__APPLE__)
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __linux__
+	return size_t(usage.ru_maxrss) * 1024;
+#else
+	return size_t(usage.ru_maxrss);
+#endif
+#else
+	return 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// glibc's malloc adds a word-sized header to each block, rounds it up to a
+// multiple of two words, and hands out no block smaller than four words.
+// Other mallocs' overheads differ, so only the request is counted.
+size_t MemoryUsage::heapBytes(const size_t requested)
+{
+	if (requested == 0)
+		return 0;
+#ifdef __GLIBC__
+	const size_t word = sizeof(void*);
+	const size_t bytes = (requested + word + 2 * word - 1) / (2 * word) * 2 * word;
+	return max(bytes, 4 * word);
+#else
+	return requested;
+#endif
+}
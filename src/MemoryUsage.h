@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        MemoryUsage.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<mutex>)
+ *
+ * Accounts for the memory held by the simulation's structures. A structure
+ * reports a MemoryUsage - its bytes broken down into named parts - counting
+ * what it holds rather than what it uses: a vector's capacity, not its size,
+ * and each heap block with the allocator's header and rounding. Structures
+ * drawing from an Arena count what they've drawn, and the arena's unused
+ * space is a part of its own.
+ *
+ * Recording a usage keeps the largest bytes reported for each of its parts,
+ * and for its total, so a run's summary can report the most any recorded
+ * snapshot of a structure held. Structures are only measured when recorded,
+ * so the largest reported is a lower bound on their true peak. The peak
+ * resident set size of the whole process is read from the system.
+ ******************************************************************************/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstddef>
+
+
+class MemoryUsage
+{
+public:
+	struct Part
+	{
+		std::string name;
+		std::size_t bytes;
+	};
+
+private:
+	std::vector<Part> parts;
+
+	// The largest bytes recorded under each name, from any thread.
+	static std::mutex sLargestMutex;
+	static std::map<std::string, std::size_t> sLargest;
+
+public:
+	// Adds a part. A part already added under the name grows by the bytes.
+	void add(const std::string& name, const std::size_t bytes);
+
+	// Adds every part of another usage, each name prefixed by the owner's.
+	void add(const std::string& owner, const MemoryUsage& usage);
+
+	const std::vector<Part>& getParts() const;
+	std::size_t total() const;
+
+	// Raises the largest reported of each part, under owner.name, and of the
+	// total, under owner.
+	void record(const std::string& owner) const;
+
+	// The most recorded under the name, or 0 if nothing was.
+	static std::size_t largestReported(const std::string& name);
+
+	// The most memory the process has held in RAM at once, or 0 if the system
+	// doesn't say.
+	static std::size_t peakResidentBytes();
+
+	// The bytes a heap block of the size takes, with malloc's header and
+	// rounding where the C library is glibc, or just the size elsewhere. A
+	// request of 0 takes no block.
+	static std::size_t heapBytes(const std::size_t requested);
+
+	// The bytes a heap-allocated vector holds.
+	template<class T> static std::size_t heapBytes(const std::vector<T>& v)
+	{
+		return heapBytes(v.capacity() * sizeof(T));
+	}
+};
@@ -0,0 +1,168 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        ProceduralWorld.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<unordered_map>, fixed width integers)
+ ******************************************************************************/
+
+#include "ProceduralWorld.h"
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include "Alchemist.h"
+
+using namespace std;
+
+namespace
+{
+	// Draws a discovery makes before giving up on finding a new variety.
+	const int sDiscoveryTries = 1000;
+
+	// The reciprocals of the effects' rarities, by id less one.
+	vector<double> effectWeights()
+	{
+		if (StatusEffect::total() < Ingredient::sMaxEffects)
+			throw logic_error("ProceduralWorld() - fewer than sMaxEffects "
+				"status effects exist to choose from.");
+
+		const vector<double>& rarities = StatusEffect::rarityTable();
+		vector<double> weights;
+		for (size_t id = 1; id < rarities.size(); id++)
+			weights.push_back(1.0 / rarities[id]);
+		return weights;
+	}
+}
+
+//------------------------------------------------------------------------------
+// The greatest forage weight belongs to an ingredient of the commonest effects,
+// so the mean of the lowest rarities bounds every variety's average.
+ProceduralWorld::ProceduralWorld(const uint64_t seed, const uint64_t varieties) :
+varieties(varieties),
+effectTable(effectWeights()), maxForageWeight(0.0)
+{
+	if (varieties == 0)
+		throw invalid_argument("ProceduralWorld() - a world needs varieties.");
+
+	this->key[0] = uint32_t(seed);
+	this->key[1] = uint32_t(seed >> 32);
+
+	vector<double> rarities(StatusEffect::rarityTable().begin() + 1,
+							StatusEffect::rarityTable().end());
+	partial_sort(rarities.begin(), rarities.begin() + Ingredient::sMaxEffects,
+				 rarities.end());
+	double lowest = 0.0;
+	for (int i = 0; i < Ingredient::sMaxEffects; i++)
+		lowest += rarities[i];
+	this->maxForageWeight = Ingredient::sMaxEffects / lowest;
+}
+
+//------------------------------------------------------------------------------
+uint64_t ProceduralWorld::size() const
+{
+	return this->varieties;
+}
+
+//------------------------------------------------------------------------------
+// The counter is the variety's index and a block number. Each block's 128 bits
+// make two draws from the effect table, repeats rejected.
+void ProceduralWorld::effectsOf(const uint64_t variety,
+								StatusEffect* effects) const
+{
+	if (variety >= this->varieties)
+		throw out_of_range("ProceduralWorld::effectsOf() - no variety has "
+			"that index.");
+
+	Philox::Counter counter = {uint32_t(variety), uint32_t(variety >> 32), 0, 0};
+	uint32_t bits[4];
+	int drawn = 0;
+	while (drawn < Ingredient::sMaxEffects)
+	{
+		Philox::generate(counter, this->key, bits);
+		counter[2]++;
+		for (int half = 0; half < 2 && drawn < Ingredient::sMaxEffects; half++)
+		{
+			const uint64_t word =
+				uint64_t(bits[2 * half]) << 32 | bits[2 * half + 1];
+			const StatusEffect effect =
+				StatusEffect::fromId(this->effectTable.sample(word) + 1);
+			if (find(effects, effects + drawn, effect) == effects + drawn)
+				effects[drawn++] = effect;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+double ProceduralWorld::forageWeightOf(const uint64_t variety) const
+{
+	StatusEffect effects[Ingredient::sMaxEffects];
+	effectsOf(variety, effects);
+
+	double rarity = 0.0;
+	for (const StatusEffect& effect : effects)
+		rarity += effect.getRarity();
+	return Ingredient::sMaxEffects / rarity;
+}
+
+//------------------------------------------------------------------------------
+// Propose varieties uniformly, accepting each by its weight over the greatest.
+uint64_t ProceduralWorld::sampleVariety(RandomStream& random) const
+{
+	for (;;)
+	{
+		const uint64_t variety = min<uint64_t>
+			(random.nextDouble() * this->varieties, this->varieties - 1);
+		if (random.nextDouble() * this->maxForageWeight
+			< forageWeightOf(variety))
+			return variety;
+	}
+}
+
+//------------------------------------------------------------------------------
+Ingredient ProceduralWorld::materialize(const uint64_t variety)
+{
+	auto iFound = this->materialized.find(variety);
+	if (iFound != this->materialized.end())
+		return Ingredient::fromId(iFound->second);
+
+	StatusEffect effects[Ingredient::sMaxEffects];
+	effectsOf(variety, effects);
+	const Ingredient ingredient = Ingredient::newIngredient(effects);
+	this->materialized[variety] = ingredient.getId();
+	return ingredient;
+}
+
+//------------------------------------------------------------------------------
+size_t ProceduralWorld::materializedCount() const
+{
+	return this->materialized.size();
+}
+
+//------------------------------------------------------------------------------
+// Each of the map's nodes holds a link to the next and an entry, and each
+// bucket a link.
+MemoryUsage ProceduralWorld::memoryUsage() const
+{
+	typedef unordered_map<uint64_t, unsigned int>::value_type Entry;
+	MemoryUsage usage;
+	usage.add("world", sizeof(ProceduralWorld));
+	usage.add("effectTable", this->effectTable.getBytesHeld());
+	usage.add("materialized",
+			  this->materialized.size()
+			  * MemoryUsage::heapBytes(sizeof(void*) + sizeof(Entry))
+			  + MemoryUsage::heapBytes(this->materialized.bucket_count()
+									   * sizeof(void*)));
+	return usage;
+}
+
+//------------------------------------------------------------------------------
+Ingredient ProceduralWorld::discover(Alchemist& alchemist, RandomStream& random)
+{
+	for (int i = 0; i < sDiscoveryTries; i++) {
+		const Ingredient ingredient = materialize(sampleVariety(random));
+		if (alchemist.discoverIngredient(ingredient))
+			return ingredient;
+	}
+	throw logic_error("ProceduralWorld::discover() - the alchemist already "
+		"knows every variety drawn.");
+}
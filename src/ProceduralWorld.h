@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        ProceduralWorld.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<unordered_map>, fixed width integers)
+ *
+ * A world of ingredient varieties too many to store. A variety's effects are
+ * derived on demand from its index, by a Philox generator keyed by the world's
+ * seed and counting from the index, so they never need storing and always come
+ * out the same. Effects are drawn as Ingredient::newIngredient() draws them -
+ * by the reciprocal of their rarity, rejecting repeats.
+ *
+ * A variety becomes an Ingredient - with an id, registered like any other -
+ * only when it's materialized, and each is materialized once, so memory grows
+ * with the varieties in play rather than the size of the world. The status
+ * effects must all exist before the world is built.
+ ******************************************************************************/
+
+#pragma once
+#include <unordered_map>
+#include <cstdint>
+#include "Ingredient.h"
+#include "AliasTable.h"
+#include "Random.h"
+#include "MemoryUsage.h"
+
+class Alchemist;
+
+
+class ProceduralWorld
+{
+	// Philox's key, from the seed.
+	uint32_t key[2];
+
+	uint64_t varieties;
+
+	// Draws effect ids, less one, by the reciprocal of their rarity.
+	AliasTable effectTable;
+
+	// No variety's forage weight is greater, for rejection sampling.
+	double maxForageWeight;
+
+	// The ingredient id of each variety materialized so far.
+	std::unordered_map<uint64_t, unsigned int> materialized;
+
+public:
+	// Builds a world of the given number of varieties. Throws logic_error if
+	// too few status effects exist to make an ingredient, or invalid_argument
+	// if there are no varieties.
+	ProceduralWorld(const uint64_t seed, const uint64_t varieties);
+
+	// The number of varieties in the world.
+	uint64_t size() const;
+
+	// Writes the variety's sMaxEffects effects. Throws out_of_range if there's
+	// no such variety.
+	void effectsOf(const uint64_t variety, StatusEffect* effects) const;
+
+	// The likelihood of the variety being foraged - the reciprocal of its
+	// effects' average rarity - worked out from its effects.
+	double forageWeightOf(const uint64_t variety) const;
+
+	// Draws a variety in proportion to its forage weight, by rejection.
+	uint64_t sampleVariety(RandomStream& random = RandomStream::local()) const;
+
+	// Returns the variety's ingredient, registering it the first time. Throws
+	// out_of_range if there's no such variety.
+	Ingredient materialize(const uint64_t variety);
+
+	// The number of varieties materialized.
+	size_t materializedCount() const;
+
+	// The memory the world holds: its effect table, and the record of
+	// materialized varieties - which grows with them.
+	MemoryUsage memoryUsage() const;
+
+	// The alchemist discovers a variety drawn by forage weight, which is
+	// returned. Varieties the alchemist knows already are drawn again; a
+	// logic_error is thrown if a thousand draws find none it doesn't know.
+	Ingredient discover(Alchemist& alchemist,
+						RandomStream& random = RandomStream::local());
+};
@@ -0,0 +1,158 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        Random.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (fixed width integers, thread_local)
+ ******************************************************************************/
+
+#include "Random.h"
+#include <atomic>
+
+using namespace std;
+
+namespace
+{
+	// Seed for threads' local streams, and the id handed to the next one.
+	atomic<uint64_t> sLocalSeed(0);
+	atomic<uint64_t> sNextLocalStreamId(0);
+
+	//--------------------------------------------------------------------------
+	uint64_t rotl(const uint64_t x, const int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+
+	//--------------------------------------------------------------------------
+	// splitmix64 - scrambles seeds into well-mixed generator states.
+	uint64_t splitMix(uint64_t& x)
+	{
+		uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	// Philox's multipliers and Weyl key increments.
+	const uint32_t sPhiloxM0 = 0xD2511F53, sPhiloxM1 = 0xCD9E8D57;
+	const uint32_t sPhiloxW0 = 0x9E3779B9, sPhiloxW1 = 0xBB67AE85;
+}
+
+//------------------------------------------------------------------------------
+// Mix the seed and stream id, then expand them into every lane's state.
+RandomStream::RandomStream(const uint64_t seed, const uint64_t streamId) :
+next(sBlockSize)
+{
+	uint64_t mix = seed;
+	mix = splitMix(mix) ^ streamId;
+	for (int l = 0; l < sLanes; l++)
+		for (int w = 0; w < 4; w++)
+			this->state[w][l] = splitMix(mix);
+}
+
+//------------------------------------------------------------------------------
+// Step all lanes together. Each pass of the inner loop is the same arithmetic
+// on different lanes, so it vectorizes.
+void RandomStream::refill()
+{
+	uint64_t (&s)[4][sLanes] = this->state;
+	for (int i = 0; i < sBlockSize; i += sLanes)
+		for (int l = 0; l < sLanes; l++)
+		{
+			this->block[i + l] = rotl(s[1][l] * 5, 7) * 9;
+
+			const uint64_t t = s[1][l] << 17;
+			s[2][l] ^= s[0][l];
+			s[3][l] ^= s[1][l];
+			s[1][l] ^= s[2][l];
+			s[0][l] ^= s[3][l];
+			s[2][l] ^= t;
+			s[3][l] = rotl(s[3][l], 45);
+		}
+	this->next = 0;
+}
+
+//------------------------------------------------------------------------------
+// Lemire's multiply-and-shift, rejecting the few values that would bias it.
+uint32_t RandomStream::nextBelow(const uint32_t bound)
+{
+	uint64_t product = (nextBits() >> 32) * bound;
+	uint32_t low = static_cast<uint32_t>(product);
+	if (low < bound)
+	{
+		const uint32_t threshold = -bound % bound;
+		while (low < threshold) {
+			product = (nextBits() >> 32) * bound;
+			low = static_cast<uint32_t>(product);
+		}
+	}
+	return product >> 32;
+}
+
+//------------------------------------------------------------------------------
+void RandomStream::fillDoubles(double* values, const int count)
+{
+	for (int i = 0; i < count; i++)
+		values[i] = nextDouble();
+}
+
+void RandomStream::fillBelow(uint32_t* values, const int count,
+							 const uint32_t bound)
+{
+	for (int i = 0; i < count; i++)
+		values[i] = nextBelow(bound);
+}
+
+//------------------------------------------------------------------------------
+// The child's seed and id are drawn from this stream.
+RandomStream RandomStream::split()
+{
+	const uint64_t seed = nextBits();
+	return RandomStream(seed, nextBits());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//                              Static methods
+//
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+// Each thread's stream is created on first use.
+RandomStream& RandomStream::local()
+{
+	thread_local RandomStream stream(sLocalSeed, sNextLocalStreamId++);
+	return stream;
+}
+
+//------------------------------------------------------------------------------
+void RandomStream::seed(const uint64_t seed)
+{
+	sLocalSeed = seed;
+	local() = RandomStream(seed, 0);
+}
+
+//------------------------------------------------------------------------------
+// Ten rounds, each two 32x32 multiplies whose halves are mixed with the key,
+// bumping the key between rounds.
+void Philox::generate(const Counter counter, const Key key, uint32_t out[4])
+{
+	uint32_t x0 = counter[0], x1 = counter[1], x2 = counter[2], x3 = counter[3];
+	uint32_t k0 = key[0], k1 = key[1];
+	for (int round = 0; round < 10; round++)
+	{
+		const uint64_t p0 = uint64_t(sPhiloxM0) * x0;
+		const uint64_t p1 = uint64_t(sPhiloxM1) * x2;
+		const uint32_t y0 = uint32_t(p1 >> 32) ^ x1 ^ k0;
+		const uint32_t y1 = uint32_t(p1);
+		const uint32_t y2 = uint32_t(p0 >> 32) ^ x3 ^ k1;
+		const uint32_t y3 = uint32_t(p0);
+		x0 = y0; x1 = y1; x2 = y2; x3 = y3;
+		k0 += sPhiloxW0;
+		k1 += sPhiloxW1;
+	}
+	out[0] = x0;
+	out[1] = x1;
+	out[2] = x2;
+	out[3] = x3;
+}
@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        SharedIngredientStore.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<atomic>)
+ ******************************************************************************/
+
+#include "SharedIngredientStore.h"
+#include <stdexcept>
+#include "Alchemist.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// Copy the source's known ingredients and their counts.
+SharedIngredientStore::SharedIngredientStore(const Alchemist& source) :
+ingredients(source.allKnownIngredients()),
+stock(new atomic<uint32_t>[ingredients.size()]), totalRemaining(0)
+{
+	for (size_t row = 0; row < this->ingredients.size(); row++)
+	{
+		const unsigned int id = this->ingredients[row].getId();
+		if (id >= this->rowsById.size())
+			this->rowsById.resize(id + 1, -1);
+		this->rowsById[id] = row;
+
+		const unsigned int count =
+			source.countOfIngredient(this->ingredients[row]);
+		this->stock[row] = count;
+		this->totalRemaining += count;
+	}
+}
+
+//------------------------------------------------------------------------------
+const vector<Ingredient>& SharedIngredientStore::allIngredients() const
+{
+	return this->ingredients;
+}
+
+//------------------------------------------------------------------------------
+unsigned int SharedIngredientStore::countOfId(const unsigned int id) const
+{
+	if (id >= this->rowsById.size() || this->rowsById[id] < 0)
+		return 0;
+	return this->stock[this->rowsById[id]];
+}
+
+//------------------------------------------------------------------------------
+// A snapshot - other alchemists may change the stock while it's counted.
+int SharedIngredientStore::calculateVarietiesInStock() const
+{
+	int varietiesInStock = 0;
+	for (size_t row = 0; row < this->ingredients.size(); row++)
+		if (this->stock[row] > 0) varietiesInStock++;
+	return varietiesInStock;
+}
+
+//------------------------------------------------------------------------------
+int SharedIngredientStore::getTotalRemaining() const
+{
+	return this->totalRemaining;
+}
+
+//------------------------------------------------------------------------------
+// Decrement each count with compare-and-swap, so it never goes below zero.
+// If one has run out, give back those already taken.
+bool SharedIngredientStore::tryClaim(const Ingredient* const* claimed,
+									 const int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const unsigned int id = claimed[i]->getId();
+		if (id >= this->rowsById.size() || this->rowsById[id] < 0) {
+			release(claimed, i);
+			return false;
+		}
+
+		atomic<uint32_t>& stock = this->stock[this->rowsById[id]];
+		uint32_t current = stock.load();
+		while (current > 0 && !stock.compare_exchange_weak(current, current - 1));
+		if (current == 0) {
+			release(claimed, i);
+			return false;
+		}
+	}
+
+	this->totalRemaining -= count;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+void SharedIngredientStore::add(const Ingredient& ingredient,
+								const unsigned int count)
+{
+	const unsigned int id = ingredient.getId();
+	if (id >= this->rowsById.size() || this->rowsById[id] < 0)
+		throw invalid_argument("SharedIngredientStore::add() - the store "
+			"doesn't hold the ingredient.");
+
+	this->stock[this->rowsById[id]] += count;
+	this->totalRemaining += count;
+}
+
+//------------------------------------------------------------------------------
+void SharedIngredientStore::release(const Ingredient* const* claimed,
+									const int count)
+{
+	for (int i = 0; i < count; i++)
+		this->stock[this->rowsById[claimed[i]->getId()]]++;
+}
@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        SharedIngredientStore.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<atomic>)
+ *
+ * A storehouse of ingredients shared by several alchemists brewing at once.
+ * Each ingredient's stock is an atomic count, claimed with compare-and-swap,
+ * so alchemists on different threads never take the same ingredient twice
+ * and never wait on a lock. A claim of several ingredients succeeds or fails
+ * as a whole.
+ *
+ * The set of ingredients is fixed when the store is built; only their counts
+ * change.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include "Ingredient.h"
+
+class Alchemist;
+
+
+class SharedIngredientStore
+{
+	// The ingredients stocked, and each one's row, indexed by id.
+	std::vector<Ingredient> ingredients;
+	std::vector<int> rowsById;
+
+	// The stock count of each row.
+	std::unique_ptr<std::atomic<uint32_t>[]> stock;
+
+	// The sum of all stock counts.
+	std::atomic<int> totalRemaining;
+
+	// Stores are shared by reference, never copied.
+	SharedIngredientStore(const SharedIngredientStore&);
+	SharedIngredientStore& operator=(const SharedIngredientStore&);
+
+public:
+	// Builds a store holding the source alchemist's stock of every ingredient
+	// it knows.
+	explicit SharedIngredientStore(const Alchemist& source);
+
+	// Returns all the ingredients the store can hold.
+	const std::vector<Ingredient>& allIngredients() const;
+
+	// Returns the stock count of the ingredient with the id - 0 if the store
+	// doesn't hold it.
+	unsigned int countOfId(const unsigned int id) const;
+
+	// Returns the number of varieties in stock, and the total count.
+	int calculateVarietiesInStock() const;
+	int getTotalRemaining() const;
+
+	// Takes one of each listed ingredient. If any has run out, none are taken
+	// and false is returned.
+	bool tryClaim(const Ingredient* const* claimed, const int count);
+
+	// Adds stock of the ingredient, which the store must hold.
+	void add(const Ingredient& ingredient, const unsigned int count);
+
+private:
+	// Returns one of each listed ingredient.
+	void release(const Ingredient* const* claimed, const int count);
+};
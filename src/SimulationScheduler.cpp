@@ -0,0 +1,196 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        SimulationScheduler.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<mutex>, <atomic>, <chrono>, <memory>)
+ ******************************************************************************/
+
+#include "SimulationScheduler.h"
+#include <chrono>
+#include <stdexcept>
+#include "Instrumentation.h"
+#include "Trace.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+SimulationScheduler::SimulationScheduler(const double sliceSeconds) :
+	sliceSeconds(sliceSeconds),
+	stopping(false)
+{
+}
+
+//------------------------------------------------------------------------------
+// A new simulation joins the back of the queue.
+int SimulationScheduler::add(const Alchemist& alchemist,
+							 const SteppedStrategy& strategy)
+{
+	unique_ptr<Simulation> simulation(new Simulation);
+	simulation->alchemist = alchemist;
+	simulation->strategy = strategy.clone();
+	simulation->steps = 0;
+	simulation->finished = false;
+	simulation->scheduled = true;
+	this->simulations.push_back(move(simulation));
+
+	const int index = this->simulations.size() - 1;
+	lock_guard<mutex> lock(this->queueMutex);
+	this->queue.push_back(index);
+	return index;
+}
+
+//------------------------------------------------------------------------------
+int SimulationScheduler::size() const
+{
+	return this->simulations.size();
+}
+
+//------------------------------------------------------------------------------
+// One loop per thread, so each thread stays busy while any simulation waits.
+// A stop is cleared only once the run it stopped has returned.
+void SimulationScheduler::run(ThreadPool& pool)
+{
+	POTIONS_PHASE("run simulations");
+
+	for (int worker = 0; worker < pool.size(); worker++)
+		pool.submit([this]() { runSlices(); });
+	pool.wait();
+	this->stopping = false;
+}
+
+//------------------------------------------------------------------------------
+void SimulationScheduler::stop()
+{
+	this->stopping = true;
+}
+
+//------------------------------------------------------------------------------
+// A simulation's lock is taken before the queue's, here as in restore(), so
+// a simulation finishing as it's restored is queued again by one or the other.
+void SimulationScheduler::runSlices()
+{
+	while (!this->stopping)
+	{
+		int index;
+		{
+			lock_guard<mutex> lock(this->queueMutex);
+			if (this->queue.empty())
+				return;
+			index = this->queue.front();
+			this->queue.pop_front();
+		}
+
+		Simulation& simulation = *this->simulations[index];
+		runSlice(simulation);
+		POTIONS_COUNT(SchedulerSlices);
+
+		lock_guard<mutex> simulationLock(simulation.mutex);
+		if (simulation.finished)
+			simulation.scheduled = false;
+		else {
+			lock_guard<mutex> lock(this->queueMutex);
+			this->queue.push_back(index);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// The clock is read after every step, which costs little beside a combine.
+void SimulationScheduler::runSlice(Simulation& simulation)
+{
+	typedef chrono::steady_clock Clock;
+	const Clock::time_point end = Clock::now()
+		+ chrono::duration_cast<Clock::duration>
+			(chrono::duration<double>(this->sliceSeconds));
+
+	for (;;)
+	{
+		{
+			lock_guard<mutex> lock(simulation.mutex);
+			if (simulation.finished)
+				return;
+			if (simulation.strategy->step(simulation.alchemist))
+				simulation.steps++;
+			else {
+				simulation.finished = true;
+				return;
+			}
+		}
+		if (this->stopping || Clock::now() >= end)
+			return;
+	}
+}
+
+//------------------------------------------------------------------------------
+SimulationScheduler::Simulation& SimulationScheduler::get
+	(const int simulation) const
+{
+	if (simulation < 0 || simulation >= size())
+		throw out_of_range("SimulationScheduler::get() - there's no such "
+			"simulation.");
+	return *this->simulations[simulation];
+}
+
+//------------------------------------------------------------------------------
+long long SimulationScheduler::getSteps(const int simulation) const
+{
+	const Simulation& s = get(simulation);
+	lock_guard<mutex> lock(s.mutex);
+	return s.steps;
+}
+
+//------------------------------------------------------------------------------
+bool SimulationScheduler::isFinished(const int simulation) const
+{
+	const Simulation& s = get(simulation);
+	lock_guard<mutex> lock(s.mutex);
+	return s.finished;
+}
+
+//------------------------------------------------------------------------------
+bool SimulationScheduler::suggestNextCombine
+	(const int simulation, Ingredient& ingredient1,
+	 Ingredient& ingredient2) const
+{
+	const Simulation& s = get(simulation);
+	lock_guard<mutex> lock(s.mutex);
+	return s.alchemist.suggestNextCombine(ingredient1, ingredient2);
+}
+
+//------------------------------------------------------------------------------
+SimulationScheduler::Checkpoint SimulationScheduler::checkpoint
+	(const int simulation) const
+{
+	const Simulation& s = get(simulation);
+	lock_guard<mutex> lock(s.mutex);
+	Checkpoint checkpoint = {s.alchemist, s.strategy->clone(), s.steps,
+							 s.finished};
+	return checkpoint;
+}
+
+//------------------------------------------------------------------------------
+// A simulation that had finished has left the queue, so rejoins it.
+void SimulationScheduler::restore(const int simulation,
+								  const Checkpoint& checkpoint)
+{
+	Simulation& s = get(simulation);
+	lock_guard<mutex> simulationLock(s.mutex);
+	s.alchemist = checkpoint.alchemist;
+	s.strategy = checkpoint.strategy->clone();
+	s.steps = checkpoint.steps;
+	s.finished = checkpoint.finished;
+
+	if (!s.finished && !s.scheduled)
+	{
+		s.scheduled = true;
+		lock_guard<mutex> lock(this->queueMutex);
+		this->queue.push_back(simulation);
+	}
+}
+
+//------------------------------------------------------------------------------
+const Alchemist& SimulationScheduler::getAlchemist(const int simulation) const
+{
+	return get(simulation).alchemist;
+}
@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        SimulationScheduler.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<mutex>, <atomic>, <chrono>, <memory>)
+ *
+ * Runs many simulations - each an alchemist and a stepped strategy - on a
+ * thread pool's few threads, by time slicing. The simulations wait their turn
+ * in a queue; a thread takes the one at the front, steps it until its slice
+ * of time is used up, and puts it back at the end unless it has finished. So
+ * thousands of simulations share the threads fairly, and any can be stopped
+ * after any combine.
+ *
+ * A simulation can be queried while the scheduler runs: its lock is held only
+ * for a step at a time, so a query waits for at most one combine. A
+ * checkpoint copies a simulation's alchemist and strategy between steps, and
+ * restoring it later resumes the simulation from there.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include "Alchemist.h"
+#include "SteppedStrategy.h"
+#include "ThreadPool.h"
+
+
+class SimulationScheduler
+{
+public:
+	// A simulation's state between steps.
+	struct Checkpoint
+	{
+		Alchemist alchemist;
+		std::unique_ptr<SteppedStrategy> strategy;
+		long long steps;
+		bool finished;
+	};
+
+private:
+	struct Simulation
+	{
+		// Held while the simulation steps, or is read or written whole.
+		mutable std::mutex mutex;
+
+		Alchemist alchemist;
+		std::unique_ptr<SteppedStrategy> strategy;
+
+		// The combines brewed so far, and whether the strategy has finished.
+		long long steps;
+		bool finished;
+
+		// Whether the simulation is in the queue or being stepped.
+		bool scheduled;
+	};
+
+	// Simulations are held by pointer, so their locks never move.
+	std::vector<std::unique_ptr<Simulation> > simulations;
+
+	// The simulations waiting for a slice, in turn.
+	std::mutex queueMutex;
+	std::deque<int> queue;
+
+	// How long a simulation is stepped before the next has its turn.
+	double sliceSeconds;
+
+	// Set by stop(), so the threads return their simulations to the queue.
+	std::atomic<bool> stopping;
+
+	// Schedulers own their simulations' locks, so can't be copied.
+	SimulationScheduler(const SimulationScheduler&);
+	SimulationScheduler& operator=(const SimulationScheduler&);
+
+	// A thread's loop: runs slices until the queue is empty or stop() is
+	// called.
+	void runSlices();
+
+	// Steps the simulation until its slice is used up, it finishes, or stop()
+	// is called.
+	void runSlice(Simulation& simulation);
+
+	// Returns the simulation, or throws out_of_range if there's no such one.
+	Simulation& get(const int simulation) const;
+
+public:
+	// Slices are a millisecond long by default.
+	explicit SimulationScheduler(const double sliceSeconds = 0.001);
+
+	// Adds a simulation of copies of the alchemist and strategy, and returns
+	// its index. Simulations mustn't be added while the scheduler runs.
+	int add(const Alchemist& alchemist, const SteppedStrategy& strategy);
+
+	// Returns the number of simulations.
+	int size() const;
+
+	// Runs the simulations on the pool's threads until every one has finished
+	// or stop() is called.
+	void run(ThreadPool& pool);
+
+	// Makes run() return once each thread's slice ends, leaving unfinished
+	// simulations queued for the next run(). A stop made before run() is
+	// called stops that run at once. May be called from any thread.
+	void stop();
+
+	// The simulation's combines so far, and whether it has finished. Throws
+	// out_of_range if there's no such simulation, as do the methods below.
+	long long getSteps(const int simulation) const;
+	bool isFinished(const int simulation) const;
+
+	// Suggests the simulation's next best combine, as
+	// Alchemist::suggestNextCombine(). May be called while the scheduler
+	// runs.
+	bool suggestNextCombine(const int simulation, Ingredient& ingredient1,
+							Ingredient& ingredient2) const;
+
+	// Copies the simulation's state between steps. May be called while the
+	// scheduler runs.
+	Checkpoint checkpoint(const int simulation) const;
+
+	// Returns the simulation to the checkpoint's state, queueing it again if
+	// it had finished. May be called while the scheduler runs.
+	void restore(const int simulation, const Checkpoint& checkpoint);
+
+	// The simulation's alchemist. Mustn't be called while the scheduler runs.
+	const Alchemist& getAlchemist(const int simulation) const;
+};
@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        SpscRing.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<atomic>, move semantics)
+ *
+ * A bounded, lock-free queue between exactly one producer thread and one
+ * consumer thread. Items are moved into a fixed ring of slots, so nothing is
+ * allocated once it's built; a full ring refuses pushes rather than growing.
+ *
+ * The producer alone writes the tail index and the consumer alone writes the
+ * head, each publishing with a release store that the other reads with an
+ * acquire load. Each side also keeps its last sight of the other's index, and
+ * only reloads it when the ring looks full or empty, so the indices' cache
+ * lines are rarely passed between cores. The indices are padded apart for the
+ * same reason.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+
+template<class T> class SpscRing
+{
+	// Keeps each side's index on its own cache line.
+	static const size_t sCacheLine = 64;
+
+	std::vector<T> slots;
+	size_t mask;
+
+	// The consumer's index, and its copy of the tail.
+	std::atomic<size_t> head;
+	size_t cachedTail;
+	char headPadding[sCacheLine - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+	// The producer's index, and its copy of the head.
+	std::atomic<size_t> tail;
+	size_t cachedHead;
+	char tailPadding[sCacheLine - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+	// Rings are shared by address between their two threads, so can't be
+	// copied.
+	SpscRing(const SpscRing&);
+	SpscRing& operator=(const SpscRing&);
+
+public:
+	// Builds a ring holding at least capacity items - rounded up to a power of
+	// two.
+	explicit SpscRing(const size_t capacity);
+
+	// The most items the ring can hold.
+	size_t capacity() const;
+
+	// Producer only. Moves the item into the ring and returns true, or returns
+	// false, leaving the item alone, if the ring is full.
+	bool tryPush(T& item);
+
+	// Consumer only. Moves the oldest item out of the ring and returns true,
+	// or returns false if the ring is empty.
+	bool tryPop(T& item);
+
+	// The number of items in the ring. Exact only when called from one of its
+	// threads while the other is idle.
+	size_t size() const;
+};
+
+//------------------------------------------------------------------------------
+template <class T>
+SpscRing<T>::SpscRing(const size_t capacity) :
+mask(0), head(0), cachedTail(0), tail(0), cachedHead(0)
+{
+	size_t size = 1;
+	while (size < capacity)
+		size *= 2;
+	this->slots.resize(size);
+	this->mask = size - 1;
+}
+
+//------------------------------------------------------------------------------
+template <class T>
+size_t SpscRing<T>::capacity() const
+{
+	return this->slots.size();
+}
+
+//------------------------------------------------------------------------------
+// The tail is the producer's own, so it's read relaxed. The head is reloaded
+// only if the cached copy says the ring is full.
+template <class T>
+bool SpscRing<T>::tryPush(T& item)
+{
+	const size_t tail = this->tail.load(std::memory_order_relaxed);
+	if (tail - this->cachedHead == this->slots.size()) {
+		this->cachedHead = this->head.load(std::memory_order_acquire);
+		if (tail - this->cachedHead == this->slots.size())
+			return false;
+	}
+
+	this->slots[tail & this->mask] = std::move(item);
+	this->tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+template <class T>
+bool SpscRing<T>::tryPop(T& item)
+{
+	const size_t head = this->head.load(std::memory_order_relaxed);
+	if (head == this->cachedTail) {
+		this->cachedTail = this->tail.load(std::memory_order_acquire);
+		if (head == this->cachedTail)
+			return false;
+	}
+
+	item = std::move(this->slots[head & this->mask]);
+	this->head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+template <class T>
+size_t SpscRing<T>::size() const
+{
+	return this->tail.load(std::memory_order_acquire)
+		- this->head.load(std::memory_order_acquire);
+}
@@ -17,24 +17,25 @@ const StatusEffect StatusEffect::nullValue = StatusEffect();
 unsigned int StatusEffect::sNextId = 1; // 0 is reserved for invalid effects.
 WeightedRandomizedStack<StatusEffect> StatusEffect::sExistingEffects =
 	WeightedRandomizedStack<StatusEffect>();
+vector<double> StatusEffect::sRarities = vector<double>(1, 0.0);
 
 //------------------------------------------------------------------------------
 // Default constructor - only used by containers and represents an invalid.
 StatusEffect::StatusEffect() :
-id(0), rarity(0)
+id(0)
 {
 }
 
 //------------------------------------------------------------------------------
 // Constructor - private, only used by static newStatusEffect method.
-StatusEffect::StatusEffect(const unsigned int id, const double rarity) :
-	id(id), rarity(rarity)
+StatusEffect::StatusEffect(const unsigned int id) :
+	id(id)
 {
 }
 
 //------------------------------------------------------------------------------
 StatusEffect::StatusEffect(const StatusEffect& rhs) :
-	id(rhs.id), rarity(rhs.rarity)
+	id(rhs.id)
 {
 }
 
@@ -42,14 +43,14 @@ StatusEffect::StatusEffect(const StatusEffect& rhs) :
 StatusEffect& StatusEffect::operator=(const StatusEffect& rhs)
 {
 	this->id = rhs.id;
-	this->rarity = rhs.rarity;
 	return *this;
 }
 
 //------------------------------------------------------------------------------
+// Looked up in the rarity table.
 double StatusEffect::getRarity() const
 {
-	return this->rarity;
+	return sRarities[this->id];
 }
 
 //------------------------------------------------------------------------------
@@ -80,8 +81,9 @@ bool StatusEffect::operator<(const StatusEffect& rhs) const
 // Static Method - build and store a new unique StatusEffect
 StatusEffect StatusEffect::newStatusEffect(const double rarity)
 {
-	// Initialize with a unique id
-	const StatusEffect statusEffect = StatusEffect(sNextId++, rarity);
+	// Initialize with a unique id, and record its rarity in the table.
+	const StatusEffect statusEffect = StatusEffect(sNextId++);
+	sRarities.push_back(rarity);
 	
 	// Store it in the weighted set, with rarity's reciprocal as probability.
 	sExistingEffects.push(statusEffect, 1.0 / rarity);
@@ -90,15 +92,24 @@ StatusEffect StatusEffect::newStatusEffect(const double rarity)
 	return statusEffect;
 }
 
+//------------------------------------------------------------------------------
+// Static method - look up an existing StatusEffect by id
+StatusEffect StatusEffect::fromId(const unsigned int id)
+{
+	if (id == 0 || id >= sNextId)
+		throw out_of_range("StatusEffect::fromId() - no effect has that id.");
+	return StatusEffect(id);
+}
+
 //------------------------------------------------------------------------------
 // Static method - returns an existing StatusEffect depending on rarity.
-const StatusEffect& StatusEffect::randomStatusEffect()
+const StatusEffect& StatusEffect::randomStatusEffect(RandomStream& random)
 {
 	// Check any StatusEffect actually exist.
 	if (sExistingEffects.isEmpty())
-		logic_error("No StatusEffects exist from which to select.");
+		throw logic_error("No StatusEffects exist from which to select.");
 	
-	return sExistingEffects.peak();
+	return sExistingEffects.peak(random);
 }
 
 WeightedRandomizedStack<StatusEffect>
@@ -112,4 +123,20 @@ WeightedRandomizedStack<StatusEffect>
 int StatusEffect::total()
 {
 	return sExistingEffects.size();
+}
+
+//------------------------------------------------------------------------------
+// Static method - read-only access to the rarity table
+const vector<double>& StatusEffect::rarityTable()
+{
+	return sRarities;
+}
+
+//------------------------------------------------------------------------------
+MemoryUsage StatusEffect::registryMemoryUsage()
+{
+	MemoryUsage usage;
+	usage.add("effects", sExistingEffects.getBytesHeld());
+	usage.add("rarities", MemoryUsage::heapBytes(sRarities));
+	return usage;
 }
\ No newline at end of file
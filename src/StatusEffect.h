@@ -10,11 +10,15 @@
  * are immutable. The class maintains a static collection of all existing 
  * StatusEffects. The static method randomStatusEffect() returns one of the
  * stored StatusEffects with a probability inversely proportional to its rarity.
+ *
+ * Rarities are kept in a single read-only table indexed by effect id, rather
+ * than in each instance, so a StatusEffect is no larger than its id.
  ******************************************************************************/
 
 #pragma once
 #include <vector>
 #include "WeightedRandomizedStack.h"
+#include "MemoryUsage.h"
 
 
 class StatusEffect
@@ -22,12 +26,8 @@ class StatusEffect
 	// Used for sorting and checking that an effect is unique.
 	unsigned int id;
 	
-	// Determines resulting potion's value and the frequency at which the
-	// status effect occurs in ingredients
-	double rarity;
-	
 	// Only used by static method - newStatusEffect(const double rarity)
-	StatusEffect(const unsigned int id, const double effectRarity);
+	explicit StatusEffect(const unsigned int id);
 	
 public:
 	StatusEffect(); // Only used by containers - uses invalid id 0.
@@ -35,6 +35,11 @@ public:
 	StatusEffect(const StatusEffect& rhs);
 	StatusEffect& operator= (const StatusEffect& rhs);
 	
+	// Inline, as the effect kernels read ids in their innermost loops.
+	unsigned int getId() const { return this->id; }
+	
+	// Determines resulting potion's value and the frequency at which the
+	// status effect occurs in ingredients. Read from the rarity table.
 	double getRarity() const;
 	
 	// Comparison operator using StatusEffects' ids
@@ -50,10 +55,15 @@ public:
 
 	// Returns a StatusEffect with a unique id
 	static StatusEffect newStatusEffect(const double rarity);
+	
+	// Returns the existing StatusEffect with the id.
+	// Throws out_of_range if no such effect exists.
+	static StatusEffect fromId(const unsigned int id);
 
 	// Returns an existing effect at random based on it's rarity.
 	// Throws logic_error if no StatusEffects exist.
-	static const StatusEffect& randomStatusEffect();
+	static const StatusEffect& randomStatusEffect
+		(RandomStream& random = RandomStream::local());
 	
 	static WeightedRandomizedStack<StatusEffect>
 		getExistingEffectsStack();
@@ -61,6 +71,13 @@ public:
 	// Returns the current number of StatusEffects in existence.
 	static int total();
 	
+	// Returns the rarity table, indexed by effect id. Entry 0 is the invalid
+	// effect, with a rarity of 0.
+	static const std::vector<double>& rarityTable();
+	
+	// The memory held by the registry of existing StatusEffects.
+	static MemoryUsage registryMemoryUsage();
+	
 	// Removes all existing StatusEffects
 	static void clearAll();
 	
@@ -76,6 +93,9 @@ private:
 	
 	// All existing status effect in a weighted set.
 	static WeightedRandomizedStack<StatusEffect> sExistingEffects;
+	
+	// The rarity of every effect, indexed by id.
+	static std::vector<double> sRarities;
 
 };
 
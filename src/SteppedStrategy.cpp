@@ -0,0 +1,239 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        SteppedStrategy.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<memory>)
+ ******************************************************************************/
+
+#include "SteppedStrategy.h"
+#include "Instrumentation.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+SteppedStrategy::~SteppedStrategy()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                              Random pairs
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+RandomPairsStrategy::RandomPairsStrategy(const RandomStream& random) :
+	random(random),
+	started(false)
+{
+}
+
+//------------------------------------------------------------------------------
+// Draws as randomlyCombineRemainingPairs() does, giving up on a draw after a
+// bounded number of tries in case a shared store runs dry meanwhile.
+bool RandomPairsStrategy::step(Alchemist& alchemist)
+{
+	if (!this->started)
+	{
+		this->ingredients = alchemist.allKnownIngredients();
+		this->started = true;
+	}
+	const uint32_t count = this->ingredients.size();
+
+	while (alchemist.calculateVarietiesInStock() > 1)
+	{
+		Ingredient ingr1, ingr2;
+		for (uint32_t tries = 0; tries < count && !alchemist.hasIngredient(ingr1);
+			 tries++)
+			ingr1 = this->ingredients[this->random.nextBelow(count)];
+		for (uint32_t tries = 0; tries < count
+			 && (!alchemist.hasIngredient(ingr2) || ingr1 == ingr2); tries++)
+			ingr2 = this->ingredients[this->random.nextBelow(count)];
+		POTIONS_COUNT(RandomPairsDrawn);
+		if (ingr1 == ingr2)
+			continue;
+
+		if (alchemist.tryCombine(ingr1, ingr2))
+			return true;
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------
+unique_ptr<SteppedStrategy> RandomPairsStrategy::clone() const
+{
+	return unique_ptr<SteppedStrategy>(new RandomPairsStrategy(*this));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                             Matching pairs
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+// The first step starts a pass, as if one had just succeeded.
+MatchingPairsStrategy::MatchingPairsStrategy() :
+	nextEffect(0),
+	index1(0),
+	index2(0),
+	succeededLastPass(true)
+{
+}
+
+//------------------------------------------------------------------------------
+// Walks each effect's ingredients with two indices, as
+// combineAllPairsWithMatchingEffects() does with iterators, returning after
+// each combine. Once an effect's walk ends the next effect's begins, and once
+// the pass's effects are walked another pass begins if this one succeeded.
+bool MatchingPairsStrategy::step(Alchemist& alchemist)
+{
+	for (;;)
+	{
+		const size_t size = this->ingredients.size();
+		if (this->index1 < size && this->index2 < size)
+		{
+			while (   this->index1 < size
+				   && !alchemist.hasIngredient(this->ingredients[this->index1]))
+				this->index1++;
+			while (   this->index2 < size
+				   && (!alchemist.hasIngredient(this->ingredients[this->index2])
+					   || this->index1 == this->index2))
+				this->index2++;
+
+			if (this->index1 < size && this->index2 < size)
+			{
+				if (alchemist.tryCombine(this->ingredients[this->index1],
+										 this->ingredients[this->index2]))
+				{
+					this->succeededLastPass = true;
+					return true;
+				}
+			}
+			continue;
+		}
+
+		// Begin the next effect's walk, skipping any with one ingredient.
+		if (this->nextEffect < this->effects.size())
+		{
+			const StatusEffect& effect = this->effects[this->nextEffect++];
+			this->ingredients.clear();
+			for (const uint32_t id : alchemist.getIngredientsWithEffect(effect))
+				this->ingredients.push_back(Ingredient::fromId(id));
+			this->index1 = 0;
+			this->index2 = 1;
+			continue;
+		}
+
+		// Begin another pass, if the last brewed anything.
+		if (!this->succeededLastPass)
+			return false;
+		this->succeededLastPass = false;
+		this->effects = alchemist.allKnownEffects();
+		this->nextEffect = 0;
+		this->ingredients.clear();
+		POTIONS_COUNT(MatchingPairsPasses);
+	}
+}
+
+//------------------------------------------------------------------------------
+unique_ptr<SteppedStrategy> MatchingPairsStrategy::clone() const
+{
+	return unique_ptr<SteppedStrategy>(new MatchingPairsStrategy(*this));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                          Value-weighted pairs
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+ValueWeightedPairsStrategy::ValueWeightedPairsStrategy
+	(const RandomStream& random) :
+	random(random)
+{
+}
+
+//------------------------------------------------------------------------------
+// The sampler is copied, so the copy resumes where the original is.
+ValueWeightedPairsStrategy::ValueWeightedPairsStrategy
+	(const ValueWeightedPairsStrategy& rhs) :
+	random(rhs.random),
+	sampler(rhs.sampler ? new ValueWeightedPairSampler(*rhs.sampler) : nullptr)
+{
+}
+
+//------------------------------------------------------------------------------
+bool ValueWeightedPairsStrategy::step(Alchemist& alchemist)
+{
+	if (!this->sampler)
+		this->sampler.reset(new ValueWeightedPairSampler(alchemist));
+
+	ValueWeightedPairSampler::Draw draw;
+	if (!this->sampler->draw(alchemist, this->random, draw))
+		return false;
+
+	const IngredientTable& table = alchemist.getIngredientTable();
+	Discovery discovery;
+	alchemist.tryCombine(table.getIngredient(draw.row1),
+						 table.getIngredient(draw.row2), &discovery);
+	this->sampler->learn(alchemist, draw, discovery);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+unique_ptr<SteppedStrategy> ValueWeightedPairsStrategy::clone() const
+{
+	return unique_ptr<SteppedStrategy>(new ValueWeightedPairsStrategy(*this));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                               Sequences
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+StrategySequence::StrategySequence() :
+	current(0)
+{
+}
+
+//------------------------------------------------------------------------------
+StrategySequence::StrategySequence(const StrategySequence& rhs) :
+	current(0)
+{
+	*this = rhs;
+}
+
+//------------------------------------------------------------------------------
+// Each strategy is cloned, so the copy resumes where the original is.
+StrategySequence& StrategySequence::operator=(const StrategySequence& rhs)
+{
+	if (this == &rhs)
+		return *this;
+
+	this->strategies.clear();
+	for (const unique_ptr<SteppedStrategy>& strategy : rhs.strategies)
+		this->strategies.push_back(strategy->clone());
+	this->current = rhs.current;
+	return *this;
+}
+
+//------------------------------------------------------------------------------
+void StrategySequence::add(const SteppedStrategy& strategy)
+{
+	this->strategies.push_back(strategy.clone());
+}
+
+//------------------------------------------------------------------------------
+bool StrategySequence::step(Alchemist& alchemist)
+{
+	while (this->current < this->strategies.size())
+	{
+		if (this->strategies[this->current]->step(alchemist))
+			return true;
+		this->current++;
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------
+unique_ptr<SteppedStrategy> StrategySequence::clone() const
+{
+	return unique_ptr<SteppedStrategy>(new StrategySequence(*this));
+}
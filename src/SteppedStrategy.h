@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        SteppedStrategy.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<memory>)
+ *
+ * Strategies that brew a combine at a time. Where the Instructor's methods
+ * run to the end once called, a stepped strategy keeps its place between
+ * calls, as a state machine: each step() brews at most one combine and
+ * returns, so a simulation can be paused after any combine, interleaved with
+ * others, or copied - strategy and alchemist together - to be resumed later.
+ *
+ * Each strategy steps as its Instructor counterpart runs, drawing on a random
+ * stream of its own.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <memory>
+#include "Alchemist.h"
+#include "Random.h"
+#include "ValueWeightedPairSampler.h"
+
+
+class SteppedStrategy
+{
+public:
+	virtual ~SteppedStrategy();
+
+	// Brews at most one combine with the alchemist. Returns false, brewing
+	// nothing, once the strategy has finished.
+	virtual bool step(Alchemist& alchemist) = 0;
+
+	// A copy of the strategy in its current state.
+	virtual std::unique_ptr<SteppedStrategy> clone() const = 0;
+};
+
+
+// Combines ingredients at random until no two varieties are in stock, as
+// Instructor::randomlyCombineRemainingPairs().
+class RandomPairsStrategy : public SteppedStrategy
+{
+	RandomStream random;
+
+	// The known ingredients, copied at the first step.
+	std::vector<Ingredient> ingredients;
+	bool started;
+
+public:
+	explicit RandomPairsStrategy(const RandomStream& random);
+
+	bool step(Alchemist& alchemist);
+	std::unique_ptr<SteppedStrategy> clone() const;
+};
+
+
+// Combines ingredient pairs known to have a common effect, pass after pass
+// while a pass brews something, as
+// Instructor::combineAllPairsWithMatchingEffects().
+class MatchingPairsStrategy : public SteppedStrategy
+{
+	// The pass's effects, copied as it starts, and the next to walk.
+	std::vector<StatusEffect> effects;
+	size_t nextEffect;
+
+	// The ingredients of the effect being walked, and the walk's place.
+	std::vector<Ingredient> ingredients;
+	size_t index1, index2;
+
+	// Whether the last pass brewed anything, so another is due.
+	bool succeededLastPass;
+
+public:
+	MatchingPairsStrategy();
+
+	bool step(Alchemist& alchemist);
+	std::unique_ptr<SteppedStrategy> clone() const;
+};
+
+
+// Combines pairs drawn in proportion to their expected value, as
+// Instructor::randomlyCombineValueWeightedPairs().
+class ValueWeightedPairsStrategy : public SteppedStrategy
+{
+	RandomStream random;
+
+	// Built from the alchemist at the first step.
+	std::unique_ptr<ValueWeightedPairSampler> sampler;
+
+public:
+	explicit ValueWeightedPairsStrategy(const RandomStream& random);
+	ValueWeightedPairsStrategy(const ValueWeightedPairsStrategy& rhs);
+
+	bool step(Alchemist& alchemist);
+	std::unique_ptr<SteppedStrategy> clone() const;
+};
+
+
+// Steps each of its strategies in turn, moving to the next as one finishes.
+class StrategySequence : public SteppedStrategy
+{
+	std::vector<std::unique_ptr<SteppedStrategy> > strategies;
+	size_t current;
+
+public:
+	StrategySequence();
+	StrategySequence(const StrategySequence& rhs);
+	StrategySequence& operator=(const StrategySequence& rhs);
+
+	// Adds a copy of the strategy, to run after those already added.
+	void add(const SteppedStrategy& strategy);
+
+	bool step(Alchemist& alchemist);
+	std::unique_ptr<SteppedStrategy> clone() const;
+};
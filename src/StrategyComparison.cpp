@@ -0,0 +1,214 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        StrategyComparison.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<functional>, <cstdint>)
+ ******************************************************************************/
+
+#include "StrategyComparison.h"
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include "Trace.h"
+
+using namespace std;
+
+namespace
+{
+	// Streams derived from the seed: one per world for discovery, one per
+	// world for foraging, and one per trial shared by the strategies.
+	const uint64_t sDiscoverySalt = 0x5b3c1f0e9a7d2641ULL;
+	const uint64_t sForageSalt = 0x9e3779b97f4a7c15ULL;
+	const uint64_t sStrategySalt = 0xc2b2ae3d27d4eb4fULL;
+
+	// Releases the ingredients made during its scope from the registry,
+	// however the scope is left.
+	class RegistryRelease
+	{
+		const unsigned int mark;
+
+	public:
+		RegistryRelease() : mark(Ingredient::registryMark()) {}
+		~RegistryRelease() { Ingredient::releaseRegistry(this->mark); }
+	};
+}
+
+//------------------------------------------------------------------------------
+StrategyComparison::Settings::Settings(const uint64_t seed) :
+ingredientCount(60), forageCount(1000), minObservations(10),
+maxObservations(1000), z(1.96), antithetic(false), seed(seed)
+{
+}
+
+//------------------------------------------------------------------------------
+StrategyComparison::RunningStats::RunningStats() :
+count(0), mean(0.0), sumOfSquares(0.0)
+{
+}
+
+//------------------------------------------------------------------------------
+void StrategyComparison::RunningStats::add(const double value)
+{
+	this->count++;
+	const double delta = value - this->mean;
+	this->mean += delta / this->count;
+	this->sumOfSquares += delta * (value - this->mean);
+}
+
+//------------------------------------------------------------------------------
+double StrategyComparison::RunningStats::variance() const
+{
+	return this->count > 1 ? this->sumOfSquares / (this->count - 1) : 0.0;
+}
+
+//------------------------------------------------------------------------------
+void StrategyComparison::addStrategy(const string& name,
+									 const Strategy& strategy)
+{
+	this->names.push_back(name);
+	this->strategies.push_back(strategy);
+}
+
+//------------------------------------------------------------------------------
+// Each observation is one trial, or the mean of an antithetic pair of trials.
+StrategyComparison::Report StrategyComparison::run
+	(const Settings& settings) const
+{
+	const size_t count = this->strategies.size();
+	if (count < 2)
+		throw logic_error("StrategyComparison::run() - at least two strategies "
+			"are needed to compare.");
+
+	vector<RunningStats> values(count), differences(count);
+	vector<double> trialValues(count), observed(count);
+
+	const int trialsPerObservation = settings.antithetic ? 2 : 1;
+	Report report;
+	report.observations = 0;
+	report.trials = 0;
+	report.z = settings.z;
+
+	// The first look, and the fraction of the limit the last was made at.
+	int nextLook = max(1, min(settings.minObservations,
+							  settings.maxObservations));
+	double lookedFraction = 0.0;
+
+	while (report.observations < settings.maxObservations)
+	{
+		// Discover this world's ingredients, to be released as the
+		// observation ends - even by an exception - so the registry doesn't
+		// grow with the observations.
+		const RegistryRelease release;
+		const int world = report.observations;
+		RandomStream discovery(settings.seed ^ sDiscoverySalt, world);
+		Alchemist unforaged;
+		for (int i = 0; i < settings.ingredientCount; i++)
+			unforaged.discoverNewIngredient(discovery);
+
+		// Forage once, or twice with mirrored draws, and run the strategies.
+		fill(observed.begin(), observed.end(), 0.0);
+		for (int pass = 0; pass < trialsPerObservation; pass++)
+		{
+			Alchemist foraged = unforaged;
+			RandomStream forage(settings.seed ^ sForageSalt, world);
+			foraged.forage(settings.forageCount, forage, pass == 1);
+
+			runTrial(foraged, report.trials++, settings.seed, trialValues);
+			for (size_t s = 0; s < count; s++)
+				observed[s] += trialValues[s] / trialsPerObservation;
+		}
+
+		for (size_t s = 0; s < count; s++) {
+			values[s].add(observed[s]);
+			differences[s].add(observed[s] - observed[0]);
+		}
+		report.observations++;
+
+		if (report.observations < nextLook)
+			continue;
+
+		// Look: stop if every difference passes this look's boundary.
+		const double fraction =
+			double(report.observations) / settings.maxObservations;
+		report.z = lookCriticalValue(settings.z, fraction, lookedFraction);
+		lookedFraction = fraction;
+		nextLook = min(2 * report.observations, settings.maxObservations);
+
+		bool allSignificant = true;
+		for (size_t s = 1; s < count; s++) {
+			const double halfWidth = report.z
+				* sqrt(differences[s].variance() / report.observations);
+			allSignificant = allSignificant
+				&& fabs(differences[s].mean) > halfWidth;
+		}
+		if (allSignificant)
+			break;
+	}
+
+	for (size_t s = 0; s < count; s++)
+	{
+		Outcome outcome;
+		outcome.name = this->names[s];
+		outcome.meanValue = values[s].mean;
+		outcome.meanDifference = differences[s].mean;
+		outcome.halfWidth = report.z
+			* sqrt(differences[s].variance() / report.observations);
+		outcome.independentHalfWidth = s == 0 ? 0.0 : report.z
+			* sqrt((values[s].variance() + values[0].variance())
+				   / report.observations);
+		outcome.significant = s > 0
+			&& fabs(outcome.meanDifference) > outcome.halfWidth;
+		report.outcomes.push_back(outcome);
+	}
+
+	return report;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//                              Private Methods
+//
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+// A two-sided test at critical value c errs with probability erfc(c / sqrt 2),
+// so the spending function is inverted by bisection on erfc, which falls as c
+// grows. A look spending nothing can't pass.
+double StrategyComparison::lookCriticalValue(const double z,
+											 const double fraction,
+											 const double previousFraction)
+{
+	const auto spent = [z](const double t) {
+		return t > 0.0 ? erfc(z / sqrt(2.0 * t)) : 0.0;
+	};
+	const double share = spent(fraction) - spent(previousFraction);
+	if (share <= 0.0)
+		return HUGE_VAL;
+
+	double low = 0.0, high = 40.0;
+	for (int i = 0; i < 100; i++) {
+		const double middle = 0.5 * (low + high);
+		if (erfc(middle / sqrt(2.0)) > share)
+			low = middle;
+		else
+			high = middle;
+	}
+	return high;
+}
+
+//------------------------------------------------------------------------------
+// Every strategy is handed an identical stream for the trial.
+void StrategyComparison::runTrial(const Alchemist& world, const int trial,
+								  const uint64_t seed,
+								  vector<double>& values) const
+{
+	for (size_t s = 0; s < this->strategies.size(); s++)
+	{
+		POTIONS_PHASE("comparison trial");
+		Alchemist alchemist = world;
+		RandomStream random(seed ^ sStrategySalt, trial);
+		this->strategies[s](alchemist, random);
+		values[s] = alchemist.getInventoryValue();
+	}
+}
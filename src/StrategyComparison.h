@@ -0,0 +1,138 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        StrategyComparison.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<functional>, <cstdint>)
+ *
+ * Compares strategies by running them all on the same worlds with the same
+ * random streams, so that a trial's luck is shared by every strategy (common
+ * random numbers). Each strategy is judged by its paired difference in
+ * inventory value from the first strategy, the baseline. Much of the noise
+ * cancels in the difference, so far fewer trials are needed than when each
+ * strategy runs with its own randomness.
+ *
+ * Each trial discovers new ingredients, forages for them, and gives every
+ * strategy a copy of the resulting alchemist. With antithetic foraging, each
+ * world is used twice - once foraged plainly, once with mirrored draws - and
+ * the pair's mean counts as one observation. A world's ingredients are
+ * released from the registry once its observation is made, so ingredients
+ * made before a comparison outlive it but none made during it do.
+ *
+ * The differences are tested at a few looks - after the minimum number of
+ * observations, then each time the count doubles, and at the limit - and
+ * trials stop at the first look where every difference is significant.
+ * Testing repeatedly would make a chance difference likelier to pass, so
+ * each look spends part of the error rate, by O'Brien-Fleming alpha spending:
+ * the share spent by a look at fraction t of the limit is erfc(z / sqrt(2t)),
+ * less what earlier looks spent. Each look's critical value tests at its own
+ * share alone, so the error rate over all the looks is at most that of the
+ * settings' z. Early looks need a large difference; the last is little
+ * stricter than a fixed-size test.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <string>
+#include <functional>
+#include <cstdint>
+#include "Alchemist.h"
+#include "Random.h"
+
+
+class StrategyComparison
+{
+public:
+	// Instructions to brew with an alchemist, drawing on the random stream.
+	typedef std::function<void(Alchemist&, RandomStream&)> Strategy;
+
+	struct Settings
+	{
+		// The world each trial builds.
+		int ingredientCount;
+		int forageCount;
+
+		// Observations made before the first look, and at most.
+		int minObservations;
+		int maxObservations;
+
+		// The normal quantile of a fixed-size test at the error rate spent
+		// over all the looks - 1.96 for 95%.
+		double z;
+
+		// Whether each world is foraged twice, antithetically.
+		bool antithetic;
+
+		// Every world and stream is derived from the seed.
+		uint64_t seed;
+
+		// Sixty ingredients, a thousand foraged, 95% intervals, 10 to 1000
+		// observations.
+		explicit Settings(const uint64_t seed = 0);
+	};
+
+	// A strategy's results, compared to the baseline's. The baseline's own
+	// difference and half-widths are zero.
+	struct Outcome
+	{
+		std::string name;
+		double meanValue;
+
+		// The mean paired difference from the baseline, and the half-width of
+		// its confidence interval.
+		double meanDifference;
+		double halfWidth;
+
+		// The half-width had the strategies used independent trials.
+		double independentHalfWidth;
+
+		// True if the interval excludes zero.
+		bool significant;
+	};
+
+	struct Report
+	{
+		// The observations made, and trials run per strategy.
+		int observations;
+		int trials;
+
+		// The critical value of the last look, which the half-widths use.
+		double z;
+
+		// One per strategy, the baseline first.
+		std::vector<Outcome> outcomes;
+	};
+
+private:
+	// Welford's running mean and variance.
+	struct RunningStats
+	{
+		int count;
+		double mean;
+		double sumOfSquares;
+
+		RunningStats();
+		void add(const double value);
+		double variance() const;
+	};
+
+	std::vector<std::string> names;
+	std::vector<Strategy> strategies;
+
+	// The critical value of a look at the given fraction of the limit, after
+	// a look at the previous fraction. The first look's previous is 0.
+	static double lookCriticalValue(const double z, const double fraction,
+									const double previousFraction);
+
+	// Runs every strategy on a copy of the world, writing their values.
+	void runTrial(const Alchemist& world, const int trial,
+				  const uint64_t seed, std::vector<double>& values) const;
+
+public:
+	// Adds a strategy. The first added is the baseline.
+	void addStrategy(const std::string& name, const Strategy& strategy);
+
+	// Runs trials until the differences are significant or the limit is met.
+	// Throws logic_error if fewer than two strategies have been added.
+	Report run(const Settings& settings) const;
+};
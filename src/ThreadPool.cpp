@@ -0,0 +1,179 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        ThreadPool.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<thread>, <mutex>, <atomic>, <functional>)
+ ******************************************************************************/
+
+#include "ThreadPool.h"
+#include <string>
+#include "Trace.h"
+
+using namespace std;
+
+namespace
+{
+	// The worker index of the calling thread, and the pool it works for.
+	thread_local int tWorker = -1;
+	thread_local const ThreadPool* tPool = nullptr;
+}
+
+//------------------------------------------------------------------------------
+ThreadPool::ThreadPool(const int threadCount) :
+queued(0), pending(0), nextWorker(0), stopping(false)
+{
+	const int count = threadCount > 0 ? threadCount : 1;
+	for (int i = 0; i < count; i++)
+		this->workers.push_back(unique_ptr<Worker>(new Worker()));
+	for (int i = 0; i < count; i++)
+		this->threads.push_back(thread(&ThreadPool::work, this, i));
+}
+
+//------------------------------------------------------------------------------
+// Let the workers drain their deques, then stop them.
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> lock(this->stateMutex);
+		this->stopping = true;
+	}
+	this->workAvailable.notify_all();
+	for (thread& t : this->threads)
+		t.join();
+}
+
+//------------------------------------------------------------------------------
+int ThreadPool::size() const
+{
+	return this->workers.size();
+}
+
+//------------------------------------------------------------------------------
+// Workers push to their own deque; other threads spread tasks round robin.
+void ThreadPool::submit(const Task& task)
+{
+	const int worker = (tPool == this) ? tWorker
+		: this->nextWorker++ % this->workers.size();
+
+	this->pending++;
+	{
+		lock_guard<mutex> lock(this->workers[worker]->mutex);
+		this->workers[worker]->tasks.push_back(task);
+	}
+	{
+		lock_guard<mutex> lock(this->stateMutex);
+		this->queued++;
+	}
+	this->workAvailable.notify_one();
+}
+
+//------------------------------------------------------------------------------
+// Help with the work until none is pending, then report any failure.
+void ThreadPool::wait()
+{
+	Task task;
+	while (this->pending > 0)
+	{
+		if (takeTask(0, task)) {
+			runTask(task);
+			continue;
+		}
+		unique_lock<mutex> lock(this->stateMutex);
+		this->allFinished.wait(lock, [this]
+			{ return this->pending == 0 || this->queued > 0; });
+	}
+
+	lock_guard<mutex> lock(this->stateMutex);
+	if (this->failure) {
+		exception_ptr failure = this->failure;
+		this->failure = nullptr;
+		rethrow_exception(failure);
+	}
+}
+
+//------------------------------------------------------------------------------
+int ThreadPool::defaultThreadCount()
+{
+	const int count = thread::hardware_concurrency();
+	return count > 0 ? count : 1;
+}
+
+//------------------------------------------------------------------------------
+int ThreadPool::currentWorker()
+{
+	return tWorker;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//                              Private methods
+//
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+// Newest first from the worker's own deque, then oldest first from the others.
+bool ThreadPool::takeTask(const int worker, Task& task)
+{
+	const int count = this->workers.size();
+	for (int i = 0; i < count; i++)
+	{
+		Worker& victim = *this->workers[(worker + i) % count];
+		lock_guard<mutex> lock(victim.mutex);
+		if (victim.tasks.empty()) continue;
+
+		if (i == 0) {
+			task = victim.tasks.back();
+			victim.tasks.pop_back();
+		}
+		else {
+			task = victim.tasks.front();
+			victim.tasks.pop_front();
+		}
+		this->queued--;
+		return true;
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------
+void ThreadPool::runTask(Task& task)
+{
+	try {
+		task();
+	}
+	catch (...) {
+		lock_guard<mutex> lock(this->stateMutex);
+		if (!this->failure)
+			this->failure = current_exception();
+	}
+	task = Task();
+
+	if (--this->pending == 0) {
+		lock_guard<mutex> lock(this->stateMutex);
+		this->allFinished.notify_all();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Run tasks while there are any, otherwise sleep until more are submitted.
+void ThreadPool::work(const int worker)
+{
+	tWorker = worker;
+	tPool = this;
+	Trace::nameThread(("pool worker " + to_string(worker)).c_str());
+
+	Task task;
+	while (true)
+	{
+		if (takeTask(worker, task)) {
+			runTask(task);
+			continue;
+		}
+		unique_lock<mutex> lock(this->stateMutex);
+		this->workAvailable.wait(lock, [this]
+			{ return this->stopping || this->queued > 0; });
+		if (this->stopping && this->queued == 0)
+			return;
+	}
+}
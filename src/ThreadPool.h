@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        ThreadPool.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<thread>, <mutex>, <atomic>, <functional>)
+ *
+ * A fixed set of worker threads sharing tasks by work stealing. Each worker
+ * has its own deque of tasks: it takes the newest task from the back of its
+ * own deque, and when that is empty steals the oldest task from the front of
+ * another's. Tasks submitted from inside a task go to the submitting worker's
+ * deque, so related work stays together until someone is idle.
+ *
+ * wait() blocks until every submitted task has finished, running tasks on the
+ * calling thread meanwhile. The first exception thrown by a task is rethrown
+ * from wait().
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+
+class ThreadPool
+{
+public:
+	typedef std::function<void()> Task;
+
+private:
+	struct Worker
+	{
+		std::deque<Task> tasks;
+		std::mutex mutex;
+	};
+
+	// One deque per worker thread.
+	std::vector<std::unique_ptr<Worker> > workers;
+	std::vector<std::thread> threads;
+
+	// Tasks queued in the deques, and tasks not yet finished.
+	std::atomic<int> queued;
+	std::atomic<int> pending;
+
+	// The deque tasks from outside the pool are pushed to next.
+	std::atomic<unsigned int> nextWorker;
+
+	// Idle workers wait for work; wait() waits for pending to reach zero.
+	std::mutex stateMutex;
+	std::condition_variable workAvailable;
+	std::condition_variable allFinished;
+	bool stopping;
+
+	// The first exception thrown by a task since the last wait().
+	std::exception_ptr failure;
+
+	// Pools own their threads, so can't be copied.
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+
+	// Takes a task from the worker's own deque, or steals one from another's.
+	bool takeTask(const int worker, Task& task);
+
+	// Runs a task, recording any exception, and notes it finished.
+	void runTask(Task& task);
+
+	// A worker thread's loop.
+	void work(const int worker);
+
+public:
+	// Starts the worker threads - one per hardware thread by default.
+	explicit ThreadPool(const int threadCount = defaultThreadCount());
+
+	// Finishes queued tasks, then joins the workers.
+	~ThreadPool();
+
+	// Returns the number of worker threads.
+	int size() const;
+
+	// Queues a task to be run by the pool.
+	void submit(const Task& task);
+
+	// Runs tasks until all submitted tasks have finished.
+	void wait();
+
+	// The number of hardware threads, or 1 if that is unknown.
+	static int defaultThreadCount();
+
+	// The index of the pool worker running the calling thread, or -1.
+	static int currentWorker();
+};
@@ -0,0 +1,173 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        Trace.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<chrono>, <atomic>, thread_local)
+ ******************************************************************************/
+
+#include "Trace.h"
+#include <vector>
+#include <string>
+#include <mutex>
+#include <chrono>
+
+using namespace std;
+
+atomic<bool> Trace::sRecording(false);
+
+namespace
+{
+	struct Event
+	{
+		const char* name;
+		double start;
+		double duration;
+	};
+
+	// A thread's track: its name, and the phases it has finished. The owning
+	// thread appends under the mutex, which only contends with writeJson().
+	struct Track
+	{
+		int id;
+		string name;
+		vector<Event> events;
+		mutex eventsMutex;
+	};
+
+	// Tracks of live threads, and those of threads that have exited.
+	struct Registry
+	{
+		mutex tracksMutex;
+		vector<Track*> tracks;
+		int nextId;
+
+		Registry() : nextId(1) {}
+		~Registry()
+		{
+			for (Track* track : tracks)
+				delete track;
+		}
+	};
+
+	Registry& registry()
+	{
+		static Registry sRegistry;
+		return sRegistry;
+	}
+
+	// Tracks outlive their threads, so phases from finished workers are kept.
+	Track& localTrack()
+	{
+		thread_local Track* tTrack = nullptr;
+		if (!tTrack)
+		{
+			Registry& r = registry();
+			lock_guard<mutex> lock(r.tracksMutex);
+			tTrack = new Track();
+			tTrack->id = r.nextId++;
+			r.tracks.push_back(tTrack);
+		}
+		return *tTrack;
+	}
+
+	// Writes the string with JSON's special characters escaped.
+	void writeString(ostream& out, const string& text)
+	{
+		out << '"';
+		for (const char c : text)
+		{
+			if (c == '"' || c == '\\')
+				out << '\\' << c;
+			else if (static_cast<unsigned char>(c) < 0x20)
+				out << ' ';
+			else
+				out << c;
+		}
+		out << '"';
+	}
+}
+
+//------------------------------------------------------------------------------
+void Trace::start()
+{
+	now();
+	sRecording = true;
+}
+
+//------------------------------------------------------------------------------
+void Trace::stop()
+{
+	sRecording = false;
+}
+
+//------------------------------------------------------------------------------
+void Trace::nameThread(const char* name)
+{
+	Track& track = localTrack();
+	lock_guard<mutex> lock(track.eventsMutex);
+	track.name = name;
+}
+
+//------------------------------------------------------------------------------
+// Phases are complete ("X") events; thread names are metadata ("M") events.
+void Trace::writeJson(ostream& out)
+{
+	Registry& r = registry();
+	lock_guard<mutex> registryLock(r.tracksMutex);
+
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << endl;
+	bool first = true;
+	for (Track* track : r.tracks)
+	{
+		lock_guard<mutex> lock(track->eventsMutex);
+		if (!track->name.empty()) {
+			out << (first ? "" : ",\n")
+				<< "{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, "
+				<< "\"tid\": " << track->id << ", \"args\": {\"name\": ";
+			writeString(out, track->name);
+			out << "}}";
+			first = false;
+		}
+		for (const Event& event : track->events) {
+			out << (first ? "" : ",\n") << "{\"ph\": \"X\", \"name\": ";
+			writeString(out, event.name);
+			out << ", \"cat\": \"phase\", \"pid\": 1, \"tid\": " << track->id
+				<< ", \"ts\": " << fixed << event.start
+				<< ", \"dur\": " << event.duration << "}";
+			out.unsetf(ios::floatfield);
+			first = false;
+		}
+	}
+	out << endl << "]}" << endl;
+}
+
+//------------------------------------------------------------------------------
+void Trace::clear()
+{
+	Registry& r = registry();
+	lock_guard<mutex> registryLock(r.tracksMutex);
+	for (Track* track : r.tracks) {
+		lock_guard<mutex> lock(track->eventsMutex);
+		track->events.clear();
+	}
+}
+
+//------------------------------------------------------------------------------
+double Trace::now()
+{
+	static const chrono::steady_clock::time_point sEpoch =
+		chrono::steady_clock::now();
+	const chrono::duration<double, micro> elapsed =
+		chrono::steady_clock::now() - sEpoch;
+	return elapsed.count();
+}
+
+//------------------------------------------------------------------------------
+void Trace::record(const char* name, const double start, const double end)
+{
+	Track& track = localTrack();
+	const Event event = {name, start, end - start};
+	lock_guard<mutex> lock(track.eventsMutex);
+	track.events.push_back(event);
+}
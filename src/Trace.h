@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        Trace.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (<chrono>, <atomic>, thread_local)
+ *
+ * Scoped phase timers, written out in Chrome's trace-event JSON format so a
+ * run can be opened in a trace viewer (chrome://tracing or Perfetto).
+ *
+ * A ScopedPhase times the scope it's declared in - best through the
+ * POTIONS_PHASE macro. Phases nest with their scopes, and each thread's phases
+ * are shown on its own track. Nothing is recorded until Trace::start() is
+ * called; until then a phase costs one relaxed load.
+ ******************************************************************************/
+
+#pragma once
+#include <ostream>
+#include <atomic>
+
+#define POTIONS_PHASE_JOIN2(a, b) a##b
+#define POTIONS_PHASE_JOIN(a, b) POTIONS_PHASE_JOIN2(a, b)
+
+// Times the rest of the enclosing scope as a phase with the given name, which
+// must be a string literal or otherwise outlive the trace.
+#define POTIONS_PHASE(name) \
+	const ScopedPhase POTIONS_PHASE_JOIN(potionsPhase, __LINE__)(name)
+
+
+class Trace
+{
+	static std::atomic<bool> sRecording;
+
+public:
+	// Starts recording phases, from every thread.
+	static void start();
+
+	// Stops recording. Recorded phases are kept.
+	static void stop();
+
+	static bool isRecording()
+	{
+		return sRecording.load(std::memory_order_relaxed);
+	}
+
+	// Labels the calling thread's track in the trace. The name is copied.
+	static void nameThread(const char* name);
+
+	// Writes every finished phase as a Chrome trace-event JSON object.
+	static void writeJson(std::ostream& out);
+
+	// Discards every finished phase.
+	static void clear();
+
+	// Microseconds since the trace's epoch - the first time it was asked.
+	static double now();
+
+	// Records a finished phase on the calling thread.
+	static void record(const char* name, const double start, const double end);
+};
+
+
+class ScopedPhase
+{
+	// Null if the trace wasn't recording when the phase began.
+	const char* name;
+	double start;
+
+	// Phases time a scope, so aren't copied.
+	ScopedPhase(const ScopedPhase&);
+	ScopedPhase& operator=(const ScopedPhase&);
+
+public:
+	explicit ScopedPhase(const char* name) :
+		name(Trace::isRecording() ? name : nullptr),
+		start(this->name ? Trace::now() : 0.0) {}
+
+	~ScopedPhase()
+	{
+		if (this->name)
+			Trace::record(this->name, this->start, Trace::now());
+	}
+};
@@ -0,0 +1,205 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        ValueWeightedPairSampler.cpp
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (fixed width integers)
+ ******************************************************************************/
+
+#include "ValueWeightedPairSampler.h"
+#include <algorithm>
+#include <stdexcept>
+#include "Instrumentation.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// Every row starts in the hidden bucket, and in the buckets of the effects
+// already known for it.
+ValueWeightedPairSampler::ValueWeightedPairSampler(const Alchemist& alchemist) :
+	liveBuckets(0),
+	recentHiddenWeight(1.0)
+{
+	if (alchemist.getSharedStore())
+		throw logic_error("ValueWeightedPairSampler() - the alchemist's store "
+			"is shared.");
+
+	// Start from the value of two random effects matching.
+	double reciprocals = 0.0;
+	for (int id = 1; id <= StatusEffect::total(); id++)
+		reciprocals += 1.0 / StatusEffect::fromId(id).getRarity();
+	this->recentHiddenValue = reciprocals > 0.0 ? 1.0 / reciprocals : 0.0;
+
+	const IngredientTable& table = alchemist.getIngredientTable();
+	const int rows = table.size();
+	this->unknownCounts.resize(rows);
+	this->effectHandles.assign(rows * Ingredient::sMaxEffects, -1);
+	this->hiddenHandles.resize(rows);
+
+	this->hiddenBucket.weight = 0;
+	this->hiddenBucket.squaredWeight = 0;
+	this->hiddenBucket.handle = this->buckets.push(0, 0.0);
+	for (int row = 0; row < rows; row++)
+	{
+		this->hiddenHandles[row] = this->hiddenBucket.rows.push(row, 0.0);
+		updateRow(alchemist, row);
+	}
+}
+
+//------------------------------------------------------------------------------
+// The row joins unweighted, to be weighted by updateRow().
+void ValueWeightedPairSampler::addToBucket(const int row, const int slot,
+										   const unsigned int effect)
+{
+	if (effect >= this->effectBuckets.size())
+		this->effectBuckets.resize(effect + 1);
+
+	Bucket& bucket = this->effectBuckets[effect];
+	if (bucket.rows.isEmpty())
+	{
+		bucket.weight = 0;
+		bucket.squaredWeight = 0;
+		bucket.handle = this->buckets.push(effect, 0.0);
+	}
+	this->effectHandles[row * Ingredient::sMaxEffects + slot] =
+		bucket.rows.push(row, 0.0);
+}
+
+//------------------------------------------------------------------------------
+// Unsigned arithmetic wraps, so the sums come out exact even as weights fall.
+void ValueWeightedPairSampler::reweight(Bucket& bucket, const int handle,
+										const uint64_t weight)
+{
+	const uint64_t old = static_cast<uint64_t>(bucket.rows.getWeight(handle));
+	bucket.weight += weight - old;
+	bucket.squaredWeight += weight * weight - old * old;
+	bucket.rows.updateWeight(handle, static_cast<double>(weight));
+}
+
+//------------------------------------------------------------------------------
+// The weight of a bucket's ordered pairs of different rows is the square of
+// its total weight, less the rows paired with themselves.
+void ValueWeightedPairSampler::reweightBucket(Bucket& bucket,
+											  const double value)
+{
+	const uint64_t pairs =
+		bucket.weight * bucket.weight - bucket.squaredWeight;
+	const double weight = value * static_cast<double>(pairs);
+
+	const bool wasLive = this->buckets.getWeight(bucket.handle) > 0.0;
+	const bool live = weight > 0.0;
+	this->liveBuckets += int(live) - int(wasLive);
+	this->buckets.updateWeight(bucket.handle, weight);
+}
+
+//------------------------------------------------------------------------------
+// A row is weighted by its stock in each known effect's bucket, and by its
+// stock times its unknown effects in the hidden bucket.
+void ValueWeightedPairSampler::updateRow(const Alchemist& alchemist,
+										 const int row)
+{
+	const IngredientTable& table = alchemist.getIngredientTable();
+	const Ingredient& ingredient = table.getIngredient(row);
+	const unsigned int stock = table.getStock(row);
+	const uint8_t known = table.getKnownMask(row);
+
+	int unknown = Ingredient::sMaxEffects;
+	for (int slot = 0; slot < Ingredient::sMaxEffects; slot++)
+	{
+		if (!(known & (1 << slot)))
+			continue;
+		unknown--;
+
+		const unsigned int effect = ingredient[slot].getId();
+		int& handle = this->effectHandles[row * Ingredient::sMaxEffects + slot];
+		if (handle < 0)
+			addToBucket(row, slot, effect);
+		Bucket& bucket = this->effectBuckets[effect];
+		reweight(bucket, handle, stock);
+		reweightBucket(bucket, ingredient[slot].getRarity());
+	}
+	this->unknownCounts[row] = unknown;
+
+	reweight(this->hiddenBucket, this->hiddenHandles[row],
+			 static_cast<uint64_t>(stock) * unknown);
+	reweightBucket(this->hiddenBucket, getHiddenValue());
+}
+
+//------------------------------------------------------------------------------
+// The first row is weighted zero while the second is drawn, so they differ.
+// Drawing the second from the rest of the weight, S - w1, would favour pairs
+// whose first row is heavy, so the first is kept with probability
+// (S - w1) / S - as if the second were drawn from all the weight and the pair
+// rejected were it the same row. A pair is then drawn in proportion to w1 w2.
+// The bucket is live, so some row weighs less than the whole and is kept.
+void ValueWeightedPairSampler::drawPair(Bucket& bucket, RandomStream& random,
+										Draw& draw)
+{
+	typedef WeightedRandomizedStack<int>::Handle Handle;
+	const double total = static_cast<double>(bucket.weight);
+	Handle handle1;
+	double weight1;
+	do {
+		handle1 = bucket.rows.sample(random);
+		weight1 = bucket.rows.getWeight(handle1);
+	} while (random.nextDouble() * total >= total - weight1);
+
+	bucket.rows.updateWeight(handle1, 0.0);
+	const Handle handle2 = bucket.rows.sample(random);
+	bucket.rows.updateWeight(handle1, weight1);
+
+	draw.row1 = bucket.rows.get(handle1);
+	draw.row2 = bucket.rows.get(handle2);
+}
+
+//------------------------------------------------------------------------------
+// A live bucket has two rows weighted above zero, so a pair can be drawn.
+bool ValueWeightedPairSampler::draw(const Alchemist& alchemist,
+									RandomStream& random, Draw& draw)
+{
+	if (this->liveBuckets == 0)
+		return false;
+
+	const unsigned int effect =
+		this->buckets.get(this->buckets.sample(random));
+	drawPair(effect ? this->effectBuckets[effect] : this->hiddenBucket,
+			 random, draw);
+	POTIONS_COUNT(RandomPairsDrawn);
+
+	const uint32_t shared = alchemist.getIngredientTable()
+		.rarestSharedKnownEffect(draw.row1, draw.row2);
+	draw.hidden = effect == 0;
+	draw.knownValue = shared ? StatusEffect::fromId(shared).getRarity() : 0.0;
+	draw.unknownPairs =
+		this->unknownCounts[draw.row1] * this->unknownCounts[draw.row2];
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Only the drawn rows can have changed. A hidden draw's potion is worth its
+// known value, or more if it found a rarer match, so what it adds is the
+// hidden value found. Hidden draws are averaged over roughly the last window
+// of them, with the starting estimate weighted as one.
+void ValueWeightedPairSampler::learn(const Alchemist& alchemist,
+									 const Draw& draw,
+									 const Discovery& discovery)
+{
+	if (draw.hidden && draw.unknownPairs > 0)
+	{
+		const int window = 32;
+		const double decay = 1.0 - 1.0 / window;
+		const double found = max(0.0, discovery.potionValue - draw.knownValue);
+		this->recentHiddenValue = this->recentHiddenValue * decay
+			+ found / draw.unknownPairs;
+		this->recentHiddenWeight = this->recentHiddenWeight * decay + 1.0;
+	}
+
+	updateRow(alchemist, draw.row1);
+	updateRow(alchemist, draw.row2);
+}
+
+//------------------------------------------------------------------------------
+double ValueWeightedPairSampler::getHiddenValue() const
+{
+	return this->recentHiddenValue / this->recentHiddenWeight;
+}
@@ -0,0 +1,125 @@
+/*******************************************************************************
+ * Project:     Potions
+ * File:        ValueWeightedPairSampler.h
+ * Author:      agent
+ * Date:        18th October 2026
+ * Standard:    C++11 (fixed width integers)
+ *
+ * Draws pairs of an alchemist's stocked ingredients in proportion to the
+ * value they're expected to brew, without scoring every pair. A pair's
+ * expected value is taken as the sum of two parts:
+ *
+ *   - the rarity of each effect known in both, and
+ *   - the hidden value of their effects not yet known, estimated per pair of
+ *     unknown effects and multiplied by the pair's number of such pairs.
+ *
+ * Each pair is weighted by its expected value times the stock of each
+ * ingredient, as if picked from the store. Since the weights are sums, pairs
+ * are drawn hierarchically: first a bucket - a known effect, weighted by its
+ * rarity times the weight of the pairs knowing it, or the hidden bucket -
+ * then two different ingredients from within it, in proportion to the product
+ * of their weights there. Every level is a WeightedRandomizedStack, so the
+ * update after a combine takes O(log n) time, and so does a draw, but for
+ * redrawing the first ingredient when it holds most of its bucket's weight.
+ *
+ * The estimate of hidden value starts from what random effects would be
+ * worth: drawn by the reciprocal of their rarity, two effects match with an
+ * expected value of one over the sum of the reciprocals. It then follows the
+ * hidden value found by the pairs drawn from the hidden bucket, as an average
+ * with exponentially falling weights.
+ *
+ * Summing known effects overestimates pairs sharing more than one, since a
+ * potion is only worth its rarest; such pairs are few.
+ ******************************************************************************/
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Alchemist.h"
+#include "WeightedRandomizedStack.h"
+#include "Random.h"
+
+
+class ValueWeightedPairSampler
+{
+public:
+	// A drawn pair of table rows, and what was known of them when drawn.
+	struct Draw
+	{
+		int row1, row2;
+
+		// True if drawn for the hidden value of its unknown effects.
+		bool hidden;
+
+		// The value of the rarest effect known in both, and the pairs of
+		// unknown effects between them.
+		double knownValue;
+		int unknownPairs;
+	};
+
+private:
+	// The rows knowing an effect, each weighted by its stock, and the sums of
+	// their weights and squared weights - which are integers, so exact.
+	struct Bucket
+	{
+		WeightedRandomizedStack<int> rows;
+		uint64_t weight;
+		uint64_t squaredWeight;
+		WeightedRandomizedStack<unsigned int>::Handle handle;
+	};
+
+	// The buckets to draw from, by effect id - or 0 for the hidden bucket.
+	WeightedRandomizedStack<unsigned int> buckets;
+	std::vector<Bucket> effectBuckets;
+	Bucket hiddenBucket;
+
+	// The buckets with pairs to draw, so the sampler knows when it's done
+	// despite rounding in the stack of buckets.
+	int liveBuckets;
+
+	// Each row's unknown effects when last updated, and its handle in the
+	// bucket of each effect slot - or -1 if the effect isn't known - and in
+	// the hidden bucket.
+	std::vector<int> unknownCounts;
+	std::vector<int> effectHandles;
+	std::vector<int> hiddenHandles;
+
+	// The hidden value of a pair of unknown effects, averaged over roughly
+	// the last window of hidden draws.
+	double recentHiddenValue;
+	double recentHiddenWeight;
+
+	// Adds the row to the effect's bucket, making the bucket if it's new.
+	void addToBucket(const int row, const int slot, const unsigned int effect);
+
+	// Re-weights a row within a bucket, keeping the bucket's sums.
+	void reweight(Bucket& bucket, const int handle, const uint64_t weight);
+
+	// Re-weights the bucket, in the stack of buckets, by its pairs' value.
+	void reweightBucket(Bucket& bucket, const double value);
+
+	// Brings the row's weights up to date with the alchemist.
+	void updateRow(const Alchemist& alchemist, const int row);
+
+	// Draws two different rows from the bucket, in proportion to the product
+	// of their weights there.
+	void drawPair(Bucket& bucket, RandomStream& random, Draw& draw);
+
+public:
+	// Weights the pairs of the alchemist's stock. Throws logic_error if the
+	// alchemist's store is shared, as stock changing elsewhere would leave the
+	// weights behind.
+	explicit ValueWeightedPairSampler(const Alchemist& alchemist);
+
+	// Draws a pair, returning false if no pair is expected to be worth
+	// anything.
+	bool draw(const Alchemist& alchemist, RandomStream& random, Draw& draw);
+
+	// Updates the weights after the drawn pair was combined, learning from
+	// its discovery.
+	void learn(const Alchemist& alchemist, const Draw& draw,
+			   const Discovery& discovery);
+
+	// The current estimate of the value of a pair of unknown effects.
+	double getHiddenValue() const;
+};
@@ -6,77 +6,117 @@
  * Standard:    C++11 (auto type)
  *
  * This template class maintains a collection of generic objects, which can be
- * retrieved with a likelihood determined by the weighting used at the time 
+ * retrieved with a likelihood determined by the weighting used at the time
  * adding the item to the collection. An  item is retrieved by choosing a random
- * number between 0 and the total weighting, and traverses the cumulative
- * weightings until one is found that is greater than the random value.
+ * number between 0 and the total weighting, and finding the item whose span of
+ * the cumulative weightings holds it.
+ *
+ * The cumulative weightings are kept in a Fenwick (binary indexed) tree, so
+ * retrieving, removing or re-weighting an item takes O(log n) time. push()
+ * returns a handle to the item, which stays valid until the item is removed;
+ * removed items' slots are reused by later pushes.
+ *
+ * Random values come from the RandomStream passed in, or the calling thread's
+ * local stream if none is.
  ******************************************************************************/
 
 #pragma once
 #include <vector>
+#include <algorithm>
 #include <stdexcept>
-#include <random>
-#include <ctime>
+#include "Random.h"
+#include "MemoryUsage.h"
 
 
 template<class T> class WeightedRandomizedStack
 {
+public:
+	// Identifies an item from when it's pushed until it's removed.
+	typedef int Handle;
+
+private:
 	struct Choice
 	{
 		T value;
 		double weighting;
-		
-		Choice(const T& v, const double w) : value(v), weighting(w) {}
-		/*Choice& operator= (const Choice& rhs)
-		{
-			this->value = rhs.value;
-			this->weighting =rhs.weighting;
-			return *this;
-		}*/
+		bool live;
+
+		Choice(const T& v, const double w) : value(v), weighting(w), live(true) {}
 	};
-	
-	// Holds the stack's values and weightings
+
+	// Holds the stack's values and weightings, by handle.
 	std::vector<Choice> choices;
-	
-	// The sum of all elements' weightings
-	double probabilitySpaceSize;
-	
-	// The set's random number generator and distribution
-	static std::default_random_engine sGenerator;
-	
+
+	// The Fenwick tree: node i holds the sum of the weightings of the slots
+	// (i - lowbit(i), i], numbering slots from 1. Its size is a power of two,
+	// so the last node holds the sum of all elements' weightings.
+	std::vector<double> tree;
+
+	// Slots of removed items, to be reused.
+	std::vector<Handle> freeSlots;
+
+	// The number of live items.
+	int count;
+
+	// Adds the delta to the slot's weighting in the tree.
+	void addToTree(const Handle handle, const double delta);
+
+	// Rebuilds the tree from the weightings, at least the given size.
+	void rebuildTree(const size_t minimumSize);
+
 public:
-	
+
 	// Initializes an empty WeightedRandomizedStack.
 	WeightedRandomizedStack<T>();
-	
+
 	// Return true if the set is empty.
 	bool isEmpty() const;
-	
+
 	// Returns is size of the set.
 	int size() const;
-	
-	// Adds the item to the set and records it's weighting.
-	void push(const T & item, const double weighting);
-	
+
+	// Adds the item to the set and records it's weighting. Returns its handle.
+	Handle push(const T & item, const double weighting);
+
 	// Retrieves an item with a probability according to it's weighting.
 	// Throws logic_error if the set is empty.
-	T pop();
-	
+	T pop(RandomStream& random = RandomStream::local());
+
 	// As above, but without removing it from the stack.
-	const T& peak();
-	
-};
+	const T& peak(RandomStream& random = RandomStream::local());
 
-//------------------------------------------------------------------------------
-// Initialize static members
-template <class T>
-std::default_random_engine WeightedRandomizedStack<T>::sGenerator =
-	std::default_random_engine(time(0));
+	// As above, but chosen by the sample u, from [0, 1), in place of a random
+	// draw - so the caller can transform its draws, e.g. to make them
+	// antithetic.
+	const T& peakAt(const double u) const;
+
+	// As above, but returns the chosen item's handle.
+	Handle sample(RandomStream& random = RandomStream::local()) const;
+	Handle sampleAt(const double u) const;
+
+	// Access by handle. Throws out_of_range if the handle isn't live.
+	const T& get(const Handle handle) const;
+	double getWeight(const Handle handle) const;
+
+	// Changes an item's weighting. An item weighted zero stays in the set,
+	// but is never chosen. Throws out_of_range if the handle isn't live.
+	void updateWeight(const Handle handle, const double weighting);
+
+	// Removes an item, freeing its handle. Throws out_of_range if the handle
+	// isn't live.
+	void remove(const Handle handle);
+
+	// The sum of all elements' weightings.
+	double totalWeight() const;
+
+	// The bytes the stack holds on the heap.
+	std::size_t getBytesHeld() const;
+};
 
 //------------------------------------------------------------------------------
 template <class T>
 WeightedRandomizedStack<T>::WeightedRandomizedStack() :
-probabilitySpaceSize(0.0)
+count(0)
 {
 }
 
@@ -85,94 +125,205 @@ probabilitySpaceSize(0.0)
 template <class T>
 bool WeightedRandomizedStack<T>::isEmpty() const
 {
-	return this->choices.empty();
+	return this->count == 0;
 }
 
 //------------------------------------------------------------------------------
 template <class T>
 int WeightedRandomizedStack<T>::size() const
 {
-	return this->choices.size();
+	return this->count;
+}
+
+//------------------------------------------------------------------------------
+// Reuse a free slot if there is one, else grow - doubling the tree if needed.
+template <class T>
+typename WeightedRandomizedStack<T>::Handle
+WeightedRandomizedStack<T>::push(const T & item, const double weighting)
+{
+	if (weighting < 0.0)
+		throw std::invalid_argument("WeightedRandomizedStack::push() - "
+			"weightings can't be negative.");
+
+	Handle handle;
+	if (!this->freeSlots.empty()) {
+		handle = this->freeSlots.back();
+		this->freeSlots.pop_back();
+		this->choices[handle] = Choice(item, weighting);
+		addToTree(handle, weighting);
+	}
+	else {
+		handle = this->choices.size();
+		this->choices.push_back(Choice(item, weighting));
+		if (this->choices.size() > this->tree.size())
+			rebuildTree(this->choices.size());
+		else
+			addToTree(handle, weighting);
+	}
+
+	this->count++;
+	return handle;
 }
 
 //------------------------------------------------------------------------------
 template <class T>
-void WeightedRandomizedStack<T>::push(const T & item, const double weighting)
-{	
-	// Store the value and weighting together as a Choice struct
-	this->choices.push_back(Choice(item, weighting));
-	
-	// Increase the size of probability space
-	this->probabilitySpaceSize += weighting;
+T WeightedRandomizedStack<T>::pop(RandomStream& random)
+{
+	const Handle handle = sample(random);
+	T value = this->choices[handle].value;
+	remove(handle);
+	return value;
 }
 
 //------------------------------------------------------------------------------
 // Returns an item with a probability according to its recorded weighting.
 // non-const because of random mechanism
 template <class T>
-T WeightedRandomizedStack<T>::pop()
+const T& WeightedRandomizedStack<T>::peak(RandomStream& random)
+{
+	return this->choices[sample(random)].value;
+}
+
+//------------------------------------------------------------------------------
+template <class T>
+const T& WeightedRandomizedStack<T>::peakAt(const double u) const
+{
+	return this->choices[sampleAt(u)].value;
+}
+
+//------------------------------------------------------------------------------
+template <class T>
+typename WeightedRandomizedStack<T>::Handle
+WeightedRandomizedStack<T>::sample(RandomStream& random) const
+{
+	return sampleAt(random.nextDouble());
+}
+
+//------------------------------------------------------------------------------
+// Descend the tree from the root, keeping the largest prefix of slots whose
+// cumulative weighting doesn't pass the sample. The slot after it holds it.
+template <class T>
+typename WeightedRandomizedStack<T>::Handle
+WeightedRandomizedStack<T>::sampleAt(const double u) const
 {
 	// Check there's an item to return.
-	if (isEmpty())
+	if (isEmpty() || totalWeight() <= 0.0)
 		throw std::logic_error("Attempted to retrieve an item from an empty"
 			"WeightedRandomizedStack");
-			
-	// Select a random number within probability space
-	std::uniform_real_distribution<double> distribution(0.0, 1.0);
-	const double randSample = distribution(sGenerator)
-							  * this->probabilitySpaceSize;
-	
-	// Find the index of the first element greater than this value in
-	// cumulative probability space.
-	double cumulativeProbabiltySpace = 0.0;
-	for (typename std::vector<Choice>::iterator it = this->choices.begin();
-		 it != choices.end(); ++it)
-	{
-		cumulativeProbabiltySpace += it->weighting;
-		if (randSample < cumulativeProbabiltySpace)
-		{
-			T value = it->value;
-			this->probabilitySpaceSize -= it->weighting;
-			
-			// Move the last choice in place of the popped choice and shrink
-			// the choices vector.
-			*it = this->choices.back();
-			this->choices.pop_back();
-			
-			return value;
+
+	// Scale the sample to probability space
+	double remaining = u * totalWeight();
+
+	size_t position = 0;
+	for (size_t step = this->tree.size() / 2; step > 0; step /= 2)
+		if (this->tree[position + step - 1] <= remaining) {
+			position += step;
+			remaining -= this->tree[position - 1];
 		}
-	}
-	
+
+	// Rounding can leave the descent on a slot that can't be chosen. Move to
+	// the nearest one that can.
+	const size_t slots = this->choices.size();
+	for (size_t i = position; i < slots; i++)
+		if (this->choices[i].live && this->choices[i].weighting > 0.0)
+			return i;
+	for (size_t i = std::min(position, slots); i-- > 0; )
+		if (this->choices[i].live && this->choices[i].weighting > 0.0)
+			return i;
+
 	throw std::length_error("tracked proabiltySpaceSize is larger than actual "
 		"value in WeightedRandomizedStack.");
 }
 
 //------------------------------------------------------------------------------
-// Returns an item with a probability according to its recorded weighting.
-// non-const because of random mechanism
 template <class T>
-const T& WeightedRandomizedStack<T>::peak()
+const T& WeightedRandomizedStack<T>::get(const Handle handle) const
 {
-	// Check there's an item to return.
-	if (isEmpty())
-		throw std::logic_error("Attempted to retrieve an item from an empty"
-			"WeightedRandomizedStack");
-			
-	// Select a random number within probability space
-	std::uniform_real_distribution<double> distribution(0.0, 1.0);
-	const double randSample = distribution(sGenerator)
-							  * this->probabilitySpaceSize;
-	
-	// Find the index of the first element greater than this value in
-	// cumulative probability space.
-	double cumulativeProbabiltySpace = 0.0;
-	for (auto it = choices.begin(); it != choices.end(); ++it)
-	{
-		cumulativeProbabiltySpace += it->weighting;
-		if (randSample < cumulativeProbabiltySpace)
-			return it->value;
+	if (   handle < 0 || handle >= static_cast<Handle>(this->choices.size())
+		|| !this->choices[handle].live)
+		throw std::out_of_range("WeightedRandomizedStack::get() - the handle "
+			"isn't live.");
+	return this->choices[handle].value;
+}
+
+//------------------------------------------------------------------------------
+template <class T>
+double WeightedRandomizedStack<T>::getWeight(const Handle handle) const
+{
+	get(handle);
+	return this->choices[handle].weighting;
+}
+
+//------------------------------------------------------------------------------
+template <class T>
+void WeightedRandomizedStack<T>::updateWeight(const Handle handle,
+											  const double weighting)
+{
+	get(handle);
+	if (weighting < 0.0)
+		throw std::invalid_argument("WeightedRandomizedStack::updateWeight() - "
+			"weightings can't be negative.");
+
+	addToTree(handle, weighting - this->choices[handle].weighting);
+	this->choices[handle].weighting = weighting;
+}
+
+//------------------------------------------------------------------------------
+// The last item empties the set, so the tree is rebuilt to clear the rounding
+// left by updates.
+template <class T>
+void WeightedRandomizedStack<T>::remove(const Handle handle)
+{
+	updateWeight(handle, 0.0);
+	this->choices[handle].live = false;
+	this->freeSlots.push_back(handle);
+
+	if (--this->count == 0)
+		rebuildTree(this->tree.size());
+}
+
+//------------------------------------------------------------------------------
+template <class T>
+double WeightedRandomizedStack<T>::totalWeight() const
+{
+	return this->tree.empty() ? 0.0 : this->tree.back();
+}
+
+//------------------------------------------------------------------------------
+template <class T>
+std::size_t WeightedRandomizedStack<T>::getBytesHeld() const
+{
+	return MemoryUsage::heapBytes(this->choices)
+		+ MemoryUsage::heapBytes(this->tree)
+		+ MemoryUsage::heapBytes(this->freeSlots);
+}
+
+//------------------------------------------------------------------------------
+template <class T>
+void WeightedRandomizedStack<T>::addToTree(const Handle handle,
+										   const double delta)
+{
+	for (size_t i = handle + 1; i <= this->tree.size(); i += i & (~i + 1))
+		this->tree[i - 1] += delta;
+}
+
+//------------------------------------------------------------------------------
+// Each node adds itself to its parent, building the tree in linear time.
+template <class T>
+void WeightedRandomizedStack<T>::rebuildTree(const size_t minimumSize)
+{
+	size_t size = 1;
+	while (size < minimumSize)
+		size *= 2;
+
+	this->tree.assign(size, 0.0);
+	for (size_t i = 0; i < this->choices.size(); i++)
+		if (this->choices[i].live)
+			this->tree[i] = this->choices[i].weighting;
+
+	for (size_t i = 1; i <= size; i++) {
+		const size_t parent = i + (i & (~i + 1));
+		if (parent <= size)
+			this->tree[parent - 1] += this->tree[i - 1];
 	}
-	
-	throw std::length_error("tracked proabiltySpaceSize is larger than actual "
-		"value in WeightedRandomizedStack.");
-}
\ No newline at end of file
+}
@@ -9,26 +9,120 @@
  * status effects found in the world of Skyrim. It then generates ingredients 
  * from these effects, and has alchemist brew potions from them following 
  * different methods. Various results are logged.
+ *
+ * Usage: potions [effects file] [--stats <file>] [--trace <file>] [--log <file>]
+ * --stats writes the hot-path counters and histograms as JSON, when built
+ * with INSTRUMENT=1. --trace writes the time taken by each phase of the run
+ * as Chrome trace-event JSON. --log writes Approach B's combines as a binary
+ * combine log. The memory held by the main structures, and the most each
+ * held, is logged at the end.
  ******************************************************************************/
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <ctime>
-#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <exception>
 #include "Alchemist.h"
 #include "Instructor.h"
+#include "Brewery.h"
+#include "StrategyComparison.h"
+#include "CompatibilityOracle.h"
+#include "CombineLog.h"
+#include "ForagingPipeline.h"
+#include "ProceduralWorld.h"
+#include "SimulationScheduler.h"
+#include "Random.h"
+#include "Instrumentation.h"
+#include "Trace.h"
 
 using namespace std;
 
+namespace
+{
+	// The scheduled simulations' streams, apart from the local streams of the
+	// seed and those the approaches derive from it.
+	const uint64_t sScheduledSalt = 0xe7037ed1a0b428dbULL;
+}
+
+//------------------------------------------------------------------------------
+// Log an approach's results, and record the alchemist's memory towards the
+// largest reported.
+void printResults(const char* approach, const Alchemist& alchemist)
+{
+	alchemist.memoryUsage().record("Alchemist");
+	cout << approach
+		 << endl
+		 << "Inventory Value: "
+		 << alchemist.getInventoryValue()
+		 << endl
+		 << "Worthless Potions: "
+		 << alchemist.getWorthlessPotionCount()
+		 << endl
+		 << "Varieties Remaining: "
+		 << alchemist.calculateVarietiesInStock()
+		 << endl
+		 << "Ingredients Remaining: "
+		 << alchemist.getTotalIngredientsRemaining()
+		 << endl << endl;
+}
+
+//------------------------------------------------------------------------------
+// Log a structure's memory part by part, now and the largest reported.
+void printMemory(const string& owner, const MemoryUsage& usage)
+{
+	usage.record(owner);
+	cout << owner
+		 << ": "
+		 << usage.total()
+		 << " (largest reported "
+		 << MemoryUsage::largestReported(owner)
+		 << ")"
+		 << endl;
+	for (const MemoryUsage::Part& part : usage.getParts())
+		cout << "  "
+			 << part.name
+			 << ": "
+			 << part.bytes
+			 << " (largest reported "
+			 << MemoryUsage::largestReported(owner + "." + part.name)
+			 << ")"
+			 << endl;
+}
+
+//------------------------------------------------------------------------------
 int main(int argc, char* argv[])
 {
+	// Find where to write optional outputs
+	const char* statsFilename = nullptr;
+	const char* traceFilename = nullptr;
+	const char* logFilename = nullptr;
+	for (int i = 2; i + 1 < argc; i++)
+		if (strcmp(argv[i], "--stats") == 0)
+			statsFilename = argv[++i];
+		else if (strcmp(argv[i], "--trace") == 0)
+			traceFilename = argv[++i];
+		else if (strcmp(argv[i], "--log") == 0)
+			logFilename = argv[++i];
+	
+	// Time the run's phases if asked to
+	if (traceFilename) {
+		Trace::nameThread("main");
+		Trace::start();
+	}
+	
 	// Seed random
-	srand(time(0));
+	const uint64_t seed = time(0);
+	RandomStream::seed(seed);
 	
 	// Read in status effects from file
 	bool readFailed = false;
 	if (argc > 1)
 	{
+		POTIONS_PHASE("load effects");
 		const char* filename = argv[1];
 		ifstream file(filename);
 		if (file.is_open())
@@ -59,49 +153,382 @@ int main(int argc, char* argv[])
 	Alchemist alchemistA = Alchemist();
 	
 	// Discover some ingredients
-	for (int i = 0; i < 60; i++)
-		alchemistA.discoverNewIngredient();
+	{
+		POTIONS_PHASE("discover ingredients");
+		for (int i = 0; i < 60; i++)
+			alchemistA.discoverNewIngredient();
+	}
 	
-	// Harvest ingredients to use
-	alchemistA.forage(1000);
+	// Keep an alchemist to forage as it brews
+	Alchemist alchemistE = alchemistA;
+	
+	// Harvest ingredients to use, across the pool's threads
+	ThreadPool pool;
+	{
+		POTIONS_PHASE("forage");
+		alchemistA.forage(1000, pool, seed);
+	}
 	
-	// Create alchemist with same conditions
+	// Create alchemists with same conditions. They outlive the phase, so it's
+	// recorded by hand.
+	const double copyStart = Trace::now();
 	Alchemist alchemistB = alchemistA;
+	Alchemist alchemistC = alchemistA;
+	Alchemist alchemistR = alchemistA;
+	Alchemist alchemistG = alchemistA;
+	Alchemist alchemistH = alchemistA;
+	Brewery brewery(alchemistA, ThreadPool::defaultThreadCount());
+	if (Trace::isRecording())
+		Trace::record("copy alchemists", copyStart, Trace::now());
+	
+	// Work out the most two-ingredient potions could earn, knowing every
+	// ingredient's true effects
+	{
+		POTIONS_PHASE("build oracle");
+		const CompatibilityOracle oracle(alchemistA.allKnownIngredients(), pool);
+		cout << "Compatible Pairs: "
+			 << oracle.pairCount()
+			 << endl
+			 << "Pair Value Bound: "
+			 << oracle.pairValueBound(alchemistA)
+			 << endl << endl;
+	}
 	
 	// See what we earn from random mixing
-	Instructor::randomlyCombineRemainingPairs(alchemistA);
-	cout << "Approach A"
+	{
+		POTIONS_PHASE("Approach A");
+		Instructor::randomlyCombineRemainingPairs(alchemistA);
+	}
+	printResults("Approach A", alchemistA);
+	
+	// See what we earn from mixing matching effects, logging each combine
+	stringstream logBytes;
+	const double strategyStart = Trace::now();
+	{
+		POTIONS_PHASE("Approach B");
+		CombineLog log(logBytes);
+		alchemistB.logCombines(&log);
+		Instructor::combineAllPairsWithMatchingEffects(alchemistB);
+		Instructor::randomlyCombineRemainingPairs(alchemistB);
+		alchemistB.logCombines(nullptr);
+	}
+	const double strategyTime = Trace::now() - strategyStart;
+	printResults("Approach B", alchemistB);
+	
+	// Replay the log on a copy of the original world
+	const double replayStart = Trace::now();
+	int replayed;
+	{
+		POTIONS_PHASE("replay Approach B");
+		replayed = CombineLog::replay(alchemistR, logBytes);
+	}
+	const double replayTime = Trace::now() - replayStart;
+	cout << "Replayed Approach B ("
+		 << replayed
+		 << " combines, "
+		 << logBytes.str().size()
+		 << " bytes)"
+		 << endl
+		 << "Inventory Value: "
+		 << alchemistR.getInventoryValue()
+		 << (alchemistR.getInventoryValue() == alchemistB.getInventoryValue()
+			 ? " (matches)" : " (differs)")
+		 << endl
+		 << "Speed-up: "
+		 << strategyTime / replayTime
+		 << endl << endl;
+	if (logFilename)
+	{
+		ofstream logFile(logFilename, ios::binary);
+		if (logFile.is_open())
+			logFile << logBytes.str();
+		else
+			cout << "Couldn't open log file " << logFilename << endl;
+	}
+	
+	// See what we earn from brewing known triples before matching pairs
+	{
+		POTIONS_PHASE("Approach C");
+		Instructor::combineAllPairsWithMatchingEffects(alchemistC);
+		Instructor::combineBestTriples(alchemistC, pool);
+		Instructor::combineAllPairsWithMatchingEffects(alchemistC);
+		Instructor::randomlyCombineRemainingPairs(alchemistC);
+	}
+	printResults("Approach C", alchemistC);
+	
+	// See how several alchemists sharing a store fare with Approach B, pooling
+	// their knowledge after each pass until none is new
+	double seconds;
+	{
+		POTIONS_PHASE("Approach D");
+		seconds = brewery.brew([&brewery](Alchemist& alchemist,
+										  RandomStream& random) {
+			do Instructor::combineAllPairsWithMatchingEffects(alchemist);
+			while (brewery.shareKnowledge(alchemist) > 0);
+			Instructor::randomlyCombineRemainingPairs(alchemist, random);
+		}, seed);
+	}
+	cout << "Approach D ("
+		 << brewery.getAlchemists().size()
+		 << " alchemists sharing a store)"
 		 << endl
 		 << "Inventory Value: "
-		 << alchemistA.getInventoryValue()
+		 << brewery.getInventoryValue()
 		 << endl
 		 << "Worthless Potions: "
-		 << alchemistA.getWorthlessPotionCount()
+		 << brewery.getWorthlessPotionCount()
 		 << endl
 		 << "Varieties Remaining: "
-		 << alchemistA.calculateVarietiesInStock()
+		 << brewery.calculateVarietiesInStock()
 		 << endl
 		 << "Ingredients Remaining: "
-		 << alchemistA.getTotalIngredientsRemaining()
+		 << brewery.getTotalIngredientsRemaining()
+		 << endl
+		 << "Brewing Time (s): "
+		 << seconds
+		 << endl << endl;
+	
+	// See what we earn brewing as we forage: arrivals are brewed with their
+	// best known partner, and what's left over as in Approach B
+	ForagingPipeline::Report streamed;
+	{
+		POTIONS_PHASE("Approach E");
+		const ForagingPipeline pipeline(64, 8);
+		streamed = pipeline.run(alchemistE, 1000, Instructor::combineArrivals);
+		Instructor::combineAllPairsWithMatchingEffects(alchemistE);
+		Instructor::randomlyCombineRemainingPairs(alchemistE);
+	}
+	alchemistE.memoryUsage().record("Alchemist");
+	cout << "Approach E (brewing while foraging)"
+		 << endl
+		 << "Inventory Value: "
+		 << alchemistE.getInventoryValue()
+		 << endl
+		 << "Worthless Potions: "
+		 << alchemistE.getWorthlessPotionCount()
+		 << endl
+		 << "Varieties Remaining: "
+		 << alchemistE.calculateVarietiesInStock()
+		 << endl
+		 << "Ingredients Remaining: "
+		 << alchemistE.getTotalIngredientsRemaining()
+		 << endl
+		 << "Batches: "
+		 << streamed.batches
+		 << " (waits: "
+		 << streamed.foragerWaits
+		 << " foraging, "
+		 << streamed.brewerWaits
+		 << " brewing)"
 		 << endl << endl;
 	
-	// See what we earn from mixing matching effects
-	Instructor::combineAllPairsWithMatchingEffects(alchemistB);
-	Instructor::randomlyCombineRemainingPairs(alchemistB);
-	cout << "Approach B"
+	// See how Approach B fares with ingredients discovered from a world of ten
+	// million varieties, of which only those discovered are ever stored
+	ProceduralWorld world(seed, 10000000);
+	Alchemist alchemistF;
+	{
+		POTIONS_PHASE("Approach F");
+		for (int i = 0; i < 60; i++)
+			world.discover(alchemistF);
+		alchemistF.forage(1000, pool, seed);
+		Instructor::combineAllPairsWithMatchingEffects(alchemistF);
+		Instructor::randomlyCombineRemainingPairs(alchemistF);
+	}
+	alchemistF.memoryUsage().record("Alchemist");
+	cout << "Approach F (procedural world)"
 		 << endl
 		 << "Inventory Value: "
-		 << alchemistB.getInventoryValue()
+		 << alchemistF.getInventoryValue()
 		 << endl
 		 << "Worthless Potions: "
-		 << alchemistB.getWorthlessPotionCount()
+		 << alchemistF.getWorthlessPotionCount()
 		 << endl
 		 << "Varieties Remaining: "
-		 << alchemistB.calculateVarietiesInStock()
+		 << alchemistF.calculateVarietiesInStock()
 		 << endl
 		 << "Ingredients Remaining: "
-		 << alchemistB.getTotalIngredientsRemaining()
+		 << alchemistF.getTotalIngredientsRemaining()
+		 << endl
+		 << "Varieties Materialized: "
+		 << world.materializedCount()
+		 << " of "
+		 << world.size()
 		 << endl << endl;
 	
+	// See what we earn from matching pairs scored in parallel and brewed in
+	// batches
+	{
+		POTIONS_PHASE("Approach G");
+		Instructor::combineSpeculatively(alchemistG, pool);
+		Instructor::randomlyCombineRemainingPairs(alchemistG);
+	}
+	printResults("Approach G (speculative matching pairs)", alchemistG);
+	
+	// See how Approach B fares stepped by a scheduler, as many simulations
+	// sharing the pool, while the last in line is asked for its next best
+	// combine
+	const int simulations = 256;
+	SimulationScheduler scheduler;
+	for (int i = 0; i < simulations; i++)
+	{
+		StrategySequence strategy;
+		strategy.add(MatchingPairsStrategy());
+		const RandomStream random(seed ^ sScheduledSalt, i);
+		strategy.add(RandomPairsStrategy(random));
+		scheduler.add(alchemistH, strategy);
+	}
+	int queries = 0;
+	double queryMicroseconds = 0.0;
+	{
+		POTIONS_PHASE("Approach H");
+		
+		// Either thread's failure is rethrown once both are done, and stops
+		// the other.
+		atomic<bool> ran(false);
+		exception_ptr runFailure, queryFailure;
+		thread background([&]() {
+			try {
+				scheduler.run(pool);
+			}
+			catch (...) {
+				runFailure = current_exception();
+			}
+			ran.store(true, memory_order_release);
+		});
+		try {
+			while (   !ran.load(memory_order_acquire)
+				   && !scheduler.isFinished(simulations - 1))
+			{
+				Ingredient ingredient1, ingredient2;
+				const double queryStart = Trace::now();
+				scheduler.suggestNextCombine(simulations - 1, ingredient1,
+											 ingredient2);
+				queryMicroseconds += Trace::now() - queryStart;
+				queries++;
+				this_thread::yield();
+			}
+		}
+		catch (...) {
+			queryFailure = current_exception();
+			scheduler.stop();
+		}
+		background.join();
+		
+		if (runFailure)
+			rethrow_exception(runFailure);
+		if (queryFailure)
+			rethrow_exception(queryFailure);
+	}
+	double scheduledValue = 0.0;
+	long long scheduledCombines = 0;
+	for (int i = 0; i < simulations; i++)
+	{
+		scheduledValue += scheduler.getAlchemist(i).getInventoryValue();
+		scheduledCombines += scheduler.getSteps(i);
+	}
+	cout << "Approach H ("
+		 << simulations
+		 << " scheduled simulations)"
+		 << endl
+		 << "Mean Inventory Value: "
+		 << scheduledValue / simulations
+		 << endl
+		 << "Combines: "
+		 << scheduledCombines
+		 << endl
+		 << "Next Combine Queries: "
+		 << queries
+		 << ", "
+		 << (queries ? queryMicroseconds / queries : 0.0)
+		 << " us each"
+		 << endl << endl;
+	
+	// Compare Approaches A and B, B stopping once combines are worth less than
+	// a common effect, B with stock-weighted random pairs, and value-weighted
+	// random pairs, on common worlds and random streams
+	StrategyComparison comparison;
+	comparison.addStrategy("Approach A", [](Alchemist& alchemist,
+											RandomStream& random) {
+		Instructor::randomlyCombineRemainingPairs(alchemist, random);
+	});
+	comparison.addStrategy("Approach B", [](Alchemist& alchemist,
+											RandomStream& random) {
+		Instructor::combineAllPairsWithMatchingEffects(alchemist);
+		Instructor::randomlyCombineRemainingPairs(alchemist, random);
+	});
+	comparison.addStrategy("Early stop", [](Alchemist& alchemist,
+											RandomStream& random) {
+		Instructor::combineAllPairsWithMatchingEffects(alchemist);
+		Instructor::randomlyCombineRemainingPairs(alchemist, random, 20.0);
+	});
+	comparison.addStrategy("Stock-weighted", [](Alchemist& alchemist,
+												RandomStream& random) {
+		Instructor::combineAllPairsWithMatchingEffects(alchemist);
+		Instructor::randomlyCombineStockWeightedPairs(alchemist, random);
+	});
+	comparison.addStrategy("Value-weighted", [](Alchemist& alchemist,
+												RandomStream& random) {
+		Instructor::randomlyCombineValueWeightedPairs(alchemist, random);
+	});
+	StrategyComparison::Settings settings(seed);
+	settings.antithetic = true;
+	StrategyComparison::Report report;
+	{
+		POTIONS_PHASE("comparison");
+		report = comparison.run(settings);
+	}
+	cout << "Comparison ("
+		 << report.trials
+		 << " trials each, z = "
+		 << report.z
+		 << ")"
+		 << endl;
+	for (const StrategyComparison::Outcome& outcome : report.outcomes)
+		cout << outcome.name
+			 << " Mean Value: "
+			 << outcome.meanValue
+			 << ", Difference: "
+			 << outcome.meanDifference
+			 << " +/- "
+			 << outcome.halfWidth
+			 << " (+/- "
+			 << outcome.independentHalfWidth
+			 << " unpaired)"
+			 << (outcome.significant ? ", significant" : "")
+			 << endl;
+	
+	// Report what the structures hold, in bytes
+	cout << endl
+		 << "Memory"
+		 << endl;
+	printMemory("Alchemist", alchemistB.memoryUsage());
+	printMemory("Procedural World", world.memoryUsage());
+	printMemory("Status Effects", StatusEffect::registryMemoryUsage());
+	printMemory("Ingredients", Ingredient::registryMemoryUsage());
+	cout << "Peak Resident Set: "
+		 << MemoryUsage::peakResidentBytes()
+		 << endl;
+	
+	// Export the phase timings
+	if (traceFilename)
+	{
+		Trace::stop();
+		ofstream trace(traceFilename);
+		if (trace.is_open())
+			Trace::writeJson(trace);
+		else
+			cout << "Couldn't open trace file " << traceFilename << endl;
+	}
+	
+	// Export the hot-path statistics
+	if (statsFilename)
+	{
+		ofstream stats(statsFilename);
+		if (stats.is_open())
+			Instrumentation::writeJson(stats);
+		else
+			cout << "Couldn't open stats file " << statsFilename << endl;
+	}
+	
 	return 0;
 }
\ No newline at end of file